@@ -0,0 +1,79 @@
+#include "dmaBdArena.h"
+#include "dmaBufferPool.h"
+#include <cassert>
+
+namespace {
+const unsigned int minClassLog2 = 12; // 4 kB (64 BDs)
+const unsigned int chunkLog2 = 21; // 2 MB: MMU block on aarch64
+const unsigned int nClasses = 32 - minClassLog2;
+
+// intrusive free list, stored in the free block itself
+typedef struct freeBlock_s {
+	struct freeBlock_s* next;
+} freeBlock_t;
+
+freeBlock_t* freeLists[nClasses] = {};
+
+// unused rest of the current chunk
+char* chunkPtr = 0;
+u32 chunkNBytesLeft = 0;
+
+u32 nBytesReserved = 0;
+
+unsigned int sizeClass(u32 nBytes){
+	unsigned int c = 0;
+	while (((u32)1 << (c + minClassLog2)) < nBytes)
+		++c;
+	assert(c < nClasses);
+	return c;
+}
+
+// uncached region of nBytes, kept until the process ends
+char* reserve(u32 nBytes){
+	dmaBufferPool* pool = new dmaBufferPool(nBytes, /*nBuffers*/1, dmaBufferPool::DMAPOOL_UNCACHED);
+	nBytesReserved += pool->getBufferSize();
+	char* p = pool->alloc(); assert(p);
+	return p;
+}
+} // namespace
+
+void* dmaBdArena::alloc(u32 nBytes){
+	assert(nBytes);
+	unsigned int c = sizeClass(nBytes);
+	u32 nBytesClass = (u32)1 << (c + minClassLog2);
+
+	// === reuse ===
+	if (freeLists[c]){
+		freeBlock_t* b = freeLists[c];
+		freeLists[c] = b->next;
+		return b;
+	}
+
+	// === blocks of a chunk or more get their own region ===
+	if (c + minClassLog2 >= chunkLog2)
+		return reserve(nBytesClass);
+
+	// === carve from the current chunk (cache line aligned, block sizes are multiples of 4 kB => blocks stay BD aligned) ===
+	if (chunkNBytesLeft < nBytesClass){
+		// the rest of the old chunk is lost (smaller classes could still use it, but rings are few)
+		chunkPtr = reserve((u32)1 << chunkLog2);
+		chunkNBytesLeft = (u32)1 << chunkLog2;
+	}
+	void* b = chunkPtr;
+	chunkPtr += nBytesClass;
+	chunkNBytesLeft -= nBytesClass;
+	return b;
+}
+
+void dmaBdArena::free(void* block, u32 nBytes){
+	if (!block)
+		return;
+	unsigned int c = sizeClass(nBytes);
+	freeBlock_t* b = (freeBlock_t*)block;
+	b->next = freeLists[c];
+	freeLists[c] = b;
+}
+
+u32 dmaBdArena::getNBytesReserved(){
+	return nBytesReserved;
+}
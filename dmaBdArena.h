@@ -0,0 +1,23 @@
+#ifndef DMABDARENA_H
+#define DMABDARENA_H
+#include "xil_types.h"
+
+// process-lifetime memory for BD rings, shared by all dmaFeed instances
+// - blocks come in power-of-two size classes (4 kB .. ) carved out of uncached 2 MB chunks (dmaBufferPool, DMAPOOL_UNCACHED)
+// - a freed block goes to the free list of its class and is reused as is => re-creating an instance costs no allocation,
+//   no MMU attribute change
+// - chunks are never returned. Application context only (constructors / destructors)
+class dmaBdArena{
+public:
+	// BD aligned block of at least nBytes
+	static void* alloc(u32 nBytes);
+
+	// nBytes as passed to alloc()
+	static void free(void* block, u32 nBytes);
+
+	// memory reserved from the system so far
+	static u32 getNBytesReserved();
+private:
+	dmaBdArena() = delete;
+};
+#endif
@@ -0,0 +1,37 @@
+#ifndef DMABDTEMPLATE_H
+#define DMABDTEMPLATE_H
+#include "xaxidma.h"
+#include <cassert>
+#include <cstring>
+
+// fast BD fill: stamps buffer address, length, control bits and ID into a BD from precomputed words
+// - the driver's BdSetBufAddr() / BdSetLength() / BdSetCtrl() write one field at a time, each reading back the (uncached)
+//   descriptor and checking its argument. stamp() only stores: words 0x08 .. 0x1F as three 64 bit stores (BD memory is normal
+//   non-cacheable, not device memory => no restriction on access size), then the ID word
+// - link (NDESC) and hardware feature words stay as set up by BdRingCreate() / BdRingClone()
+// - argument checks are asserts only. Word pairs are composed for a little-endian CPU (Zynq, ZynqMP, MicroBlaze LE)
+class dmaBdTemplate{
+public:
+	// mcctl / stride: multichannel control (Tx: TDEST, TID) and 2D words of every stamped BD. 0 as cloned from a cleared BD
+	dmaBdTemplate(u32 mcctl = 0, u32 stride = 0) : mcctlStride((u64)stride << 32 | mcctl){}
+
+	// ctrlBits: XAXIDMA_BD_CTRL_TXSOF_MASK / _TXEOF_MASK (Tx), 0 (Rx). Clears the status word
+	void stamp(XAxiDma_Bd* bdPtr, UINTPTR addr, u32 nBytes, u32 ctrlBits, u32 lengthMask, UINTPTR id) const{
+		assert(nBytes && (nBytes <= lengthMask) && "BD length out of range"); (void)lengthMask;
+		assert(!(ctrlBits & ~XAXIDMA_BD_CTRL_ALL_MASK) && "invalid BD control bits");
+		u64 bufa = (u64)addr; // BUFA, BUFA_MSB
+		u64 ctrlLenSts = nBytes | ctrlBits; // CTRL_LEN, STS
+		char* p = (char*)bdPtr;
+		// memcpy: plain 64 bit stores without aliasing the u32 BD words
+		memcpy(p + XAXIDMA_BD_BUFA_OFFSET, &bufa, sizeof(u64));
+		memcpy(p + XAXIDMA_BD_MCCTL_OFFSET, &mcctlStride, sizeof(u64));
+		memcpy(p + XAXIDMA_BD_CTRL_LEN_OFFSET, &ctrlLenSts, sizeof(u64));
+		XAxiDma_BdSetId(bdPtr, id);
+	}
+private:
+	static_assert((XAXIDMA_BD_BUFA_MSB_OFFSET == XAXIDMA_BD_BUFA_OFFSET + 4) && (XAXIDMA_BD_STRIDE_VSIZE_OFFSET == XAXIDMA_BD_MCCTL_OFFSET + 4)
+			&& (XAXIDMA_BD_STS_OFFSET == XAXIDMA_BD_CTRL_LEN_OFFSET + 4), "BD layout");
+	// MCCTL, STRIDE_VSIZE
+	const u64 mcctlStride;
+};
+#endif
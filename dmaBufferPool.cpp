@@ -0,0 +1,101 @@
+#include "dmaBufferPool.h"
+#include "xil_cache.h"
+#include "xil_exception.h"
+#include "xil_mmu.h"
+#include <cstdlib>
+
+namespace {
+// translation table granularity for DMAPOOL_UNCACHED (https://docs.xilinx.com/r/2021.1-English/oslib_rm/Xil_SetTlbAttributes)
+// 2 MB for the first 32 bits on aarch64, 1 MB sections on Cortex-A9
+#if defined(__aarch64__) && !defined(XHOST_MODEL)
+#	define DMAPOOL_HAS_MMU
+const u32 mmuBlock = 0x200000;
+const u64 attrUncached = /*MARK_UNCACHEABLE, as for the BD rings in dmaFeedBase*/0x701;
+#elif defined(__arm__) && !defined(XHOST_MODEL)
+#	define DMAPOOL_HAS_MMU
+const u32 mmuBlock = 0x100000;
+const u64 attrUncached = NORM_NONCACHE;
+#endif
+
+u32 roundUp(u32 v, u32 granularity){
+	return (v + granularity - 1) / granularity * granularity;
+}
+} // namespace
+
+dmaBufferPool::dmaBufferPool(u32 bufferSize, unsigned int nBuffers, memory_e memory) :
+	stride(roundUp(bufferSize, DMAFEED_CACHE_LINE)), nBuffers(nBuffers), nextFree(new unsigned int[nBuffers]){
+	assert(bufferSize && nBuffers);
+	u32 nBytes = stride * nBuffers;
+	assert(nBytes / nBuffers == stride && "pool size overflows 32 bits");
+
+#ifdef DMAPOOL_HAS_MMU
+	if (memory == DMAPOOL_UNCACHED){
+		// whole translation blocks: unrelated data must not end up in memory with cache disabled
+		nBytesRegion = roundUp(nBytes, mmuBlock);
+		region = (char*)aligned_alloc(/*alignment*/mmuBlock, nBytesRegion);
+		assert(region && "aligned_alloc failed");
+		assert(((uintptr_t)region + nBytesRegion <= 0x100000000) && "aligned_alloc returned memory beyond 32 bit address space. Refusing to disable cache for a whole gigabyte section...");
+		// no dirty lines may be written back into the region once it is uncached
+		Xil_DCacheFlushRange((INTPTR)region, nBytesRegion);
+		for (u32 offset = 0; offset < nBytesRegion; offset += mmuBlock)
+			Xil_SetTlbAttributes((UINTPTR)(region + offset), attrUncached);
+		uncached = true;
+	}
+#else
+	(void)memory; // host model: coherent. No MMU: nothing to configure
+#endif
+	if (!region){
+		region = (char*)aligned_alloc(DMAFEED_CACHE_LINE, nBytes);
+		assert(region && "aligned_alloc failed");
+	}
+
+	// === all buffers free, in address order ===
+	for (unsigned int ix = 0; ix < nBuffers; ++ix)
+		nextFree[ix] = (ix + 1 < nBuffers) ? ix + 1 : NONE;
+	firstFree = 0;
+	nFree = nBuffers;
+}
+
+dmaBufferPool::~dmaBufferPool(){
+	assert((nFree == nBuffers) && "buffers still allocated");
+#ifdef DMAPOOL_HAS_MMU
+	// the heap gets the region back with default attributes
+	if (uncached)
+		for (u32 offset = 0; offset < nBytesRegion; offset += mmuBlock)
+			Xil_SetTlbAttributes((UINTPTR)(region + offset), NORM_WB_CACHE);
+#endif
+	::free(region);
+	delete[] nextFree;
+}
+
+char* dmaBufferPool::alloc(){
+	Xil_ExceptionDisable();
+	char* buf = allocFromIsr();
+	Xil_ExceptionEnable();
+	return buf;
+}
+
+void dmaBufferPool::free(char* buf){
+	Xil_ExceptionDisable();
+	freeFromIsr(buf);
+	Xil_ExceptionEnable();
+}
+
+char* dmaBufferPool::allocFromIsr(){
+	unsigned int ix = firstFree;
+	if (ix == NONE)
+		return NULL;
+	firstFree = nextFree[ix];
+	nextFree[ix] = NONE;
+	--nFree;
+	return getBuffer(ix);
+}
+
+void dmaBufferPool::freeFromIsr(char* buf){
+	unsigned int ix = getIndex(buf);
+	assert((buf == getBuffer(ix)) && "not the start of a pool buffer");
+	assert((nFree < nBuffers) && "free() without alloc()");
+	nextFree[ix] = firstFree;
+	firstFree = ix;
+	++nFree;
+}
@@ -0,0 +1,65 @@
+#ifndef DMABUFFERPOOL_H
+#define DMABUFFERPOOL_H
+#include "xil_types.h"
+#include <cassert>
+
+// DMA buffers share no cache line with other data (flush / invalidate of a buffer must not touch its neighbours)
+// 64 bytes covers Cortex-A53 (64) and Cortex-A9 (32)
+#ifndef DMAFEED_CACHE_LINE
+#	define DMAFEED_CACHE_LINE 64
+#endif
+
+// fixed-size DMA buffers carved out of one region that is reserved at construction
+// - each buffer starts on a cache line and is rounded up to whole cache lines
+// - DMAPOOL_UNCACHED: the region is marked uncacheable at MMU granularity (aarch64: 2 MB blocks, Cortex-A9: 1 MB sections),
+//   rounded up so that no unrelated data shares it. No cache maintenance needed for its buffers (e.g. BD rings).
+//   Host model and targets without MMU: ordinary memory
+// - alloc() / free() are O(1) from a free list of buffer indices and never call malloc
+class dmaBufferPool{
+public:
+	typedef enum {
+		DMAPOOL_CACHED=0,
+		DMAPOOL_UNCACHED} memory_e;
+
+	dmaBufferPool(u32 bufferSize, unsigned int nBuffers, memory_e memory = DMAPOOL_CACHED);
+	~dmaBufferPool();
+	dmaBufferPool(const dmaBufferPool&) = delete;
+	dmaBufferPool& operator=(const dmaBufferPool&) = delete;
+
+	// application context (masks interrupts around the free list). Returns NULL if the pool is exhausted
+	char* alloc();
+	void free(char* buf);
+
+	// interrupt context (already masked), or application code that owns the pool exclusively
+	char* allocFromIsr();
+	void freeFromIsr(char* buf);
+
+	// usable bytes per buffer (requested size rounded up to cache lines)
+	u32 getBufferSize() const {return stride;}
+	unsigned int getNBuffers() const {return nBuffers;}
+	unsigned int getNFree() const {return nFree;}
+
+	// buffer <=> index in the pool (e.g. for a 32 bit BD ID)
+	unsigned int getIndex(const char* buf) const {assert(contains(buf)); return (buf - region) / stride;}
+	char* getBuffer(unsigned int ix) const {assert(ix < nBuffers); return region + ix * stride;}
+	bool contains(const char* p) const {return (p >= region) && (p < region + nBuffers * stride);}
+private:
+	// list end
+	static const unsigned int NONE = ~0u;
+
+	const u32 stride;
+	const unsigned int nBuffers;
+
+	// start of the first buffer
+	char* region = NULL;
+
+	// next free buffer for each free buffer, NONE terminates (kept outside the buffers: uncached / DMA-owned memory)
+	unsigned int* const nextFree;
+	unsigned int firstFree = NONE;
+	volatile unsigned int nFree = 0;
+
+	// DMAPOOL_UNCACHED region (whole translation blocks), attributes restored on destruction
+	bool uncached = false;
+	u32 nBytesRegion = 0;
+};
+#endif
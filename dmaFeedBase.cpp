@@ -1,44 +1,58 @@
-#include "dmaFeedBase.h"
+#include "dmaFeedBaseIsr.h"
+#include "dmaBdArena.h"
+#include <cstdlib>
 
 #ifndef DEBUG
 extern void xil_printf(const char *format, ...);
 #endif
 
-#ifdef DMAFEED_HAS_INTC
-	XIntc dmaFeedBase::iIntc;
-#endif
-#ifdef DMAFEED_HAS_SCUGIC
-	XScuGic dmaFeedBase::iIntc;
-#endif
+namespace {
+u32 clamp(u32 v, u32 lo, u32 hi){
+	return (v < lo) ? lo : (v > hi) ? hi : v;
+}
+} // namespace
 
-dmaFeedBase::dmaFeedBase(const dmaFeedBaseConfig& config) : config(config){
+dmaFeedBase::dmaFeedBase(const dmaFeedBaseConfig& config) : config(config),
+	txCallback((Xil_InterruptHandler)txInterruptCallback<virtualDispatch>), rxCallback((Xil_InterruptHandler)rxInterruptCallback<virtualDispatch>){
 	// === allocate memory for buffer descriptor rings ===
 
-#ifdef __aarch64__
-	nBytesAllocTxBd = 0x10000; // DMA SG sample code uses 64k. TODO: Should use 1M
-	nBytesAllocRxBd = 0x10000; // DMA SG sample code uses 64k. TODO: Should use 1M
-
-	// need to disable cache, as DMA is not IO coherent (https://docs.xilinx.com/r/en-US/ug1085-zynq-ultrascale-trm/Full-Coherency)
-	// translation table resolution is 2 MB for the first 32 bits, then 4 GB (https://docs.xilinx.com/r/2021.1-English/oslib_rm/Xil_SetTlbAttributes)
-	// So we reserve an aligned 2 MB chunk prevent that unrelated data gets alloc'd into the same region with cache disabled
-	u32 twoMB =  0x200000;
-	assert(twoMB >= nAllocTxBD + nAllocRxBD);
-	bufferDescriptorSpace = aligned_alloc(/*alignment*/twoMB, /*size*/twoMB);
-	assert(((uintptr_t)bufferDescriptorSpace < 0x100000000) && "aligned_alloc returned memory beyond 32 bit address space. Refusing to disable cache for a whole gigabyte section...");
-	Xil_SetTlbAttributes(bufferDescriptorSpace, /*MARK_UNCACHEABLE*/0x701);
-#else
-	nBytesAllocTxBd = 0x10000; // DMA SG sample code uses 64k
-	nBytesAllocRxBd = 0x10000; // DMA SG sample code uses 64k
-
-	// use consistent approach with single free() as in aarch64 above.
-	// Correct alignment already here isn't strictly necessary.
-	bufferDescriptorSpace = aligned_alloc(XAXIDMA_BD_MINIMUM_ALIGNMENT, nBytesAllocTxBd+nBytesAllocRxBd); // space for Tx and Rx. Only this gets free()d
-	assert(bufferDescriptorSpace && "aligned_alloc failed");
+	// unused channel: no ring
+	nBytesAllocTxBd = config.useTx ? config.nBytesAllocTxBd : 0;
+	nBytesAllocRxBd = config.useRx ? config.nBytesAllocRxBd : 0;
+	assert((config.useTx || config.useRx) && "no channel in use");
+#ifdef XPAR_CPU_ID
+	assert(((config.irqCpu < 0) || (config.irqCpu == XPAR_CPU_ID)) && "irqCpu: the instance must live on the CPU that takes its interrupts");
 #endif
+	assert(!(nBytesAllocTxBd % XAXIDMA_BD_MINIMUM_ALIGNMENT) && !(nBytesAllocRxBd % XAXIDMA_BD_MINIMUM_ALIGNMENT) && "BD space must be a multiple of BD alignment");
+	assert((config.nRxChannels >= 1) && (config.nRxChannels <= XAXIDMA_MAX_NUM_CHANNELS) && "invalid number of Rx channels");
+	assert((!config.rxCyclic || (config.nRxChannels == 1)) && "cyclic BD mode needs a single Rx channel");
+	assert((!config.rxCyclic || config.useRx) && "cyclic BD mode needs Rx");
+	if (config.bdSpace){
+		assert(!((uintptr_t)config.bdSpace % XAXIDMA_BD_MINIMUM_ALIGNMENT) && "bdSpace must be BD aligned");
+		bufferDescriptorSpace = config.bdSpace;
+	} else {
+		// need to disable cache, as DMA is not IO coherent (https://docs.xilinx.com/r/en-US/ug1085-zynq-ultrascale-trm/Full-Coherency)
+		// the arena keeps uncached memory after destruction => re-creating an instance is cheap
+		bufferDescriptorSpace = dmaBdArena::alloc(nBytesAllocTxBd + config.nRxChannels * nBytesAllocRxBd); // space for Tx and all Rx rings
+		bdSpaceIsOwned = true;
+	}
 	// split single alloc into Tx and Rx space
 	txBdBufSpace = (void*)((char*)bufferDescriptorSpace + /*byte (aka char) offset*/0 );
 	rxBdBufSpace = (void*)((char*)bufferDescriptorSpace + /*byte (aka char) offset*/nBytesAllocTxBd);
 
+	// === initial coalescing (fixed unless adaptive) ===
+	txCoalesce = {config.coalesceNTxInterrupts, config.coalesceDelayTx, 0};
+	rxCoalesce = {config.coalesceNRxInterrupts, config.coalesceDelayRx, 0};
+	if (config.coalesceAdaptive){
+		assert((config.coalesceNMin >= 1) && (config.coalesceNMin <= config.coalesceNMax) && (config.coalesceNMax <= 255) && "invalid adaptive coalescing count bounds");
+		assert((config.coalesceDelayMin >= 1) && (config.coalesceDelayMin <= config.coalesceDelayMax) && (config.coalesceDelayMax <= 255) && "invalid adaptive coalescing delay bounds");
+		txCoalesce.n = clamp(txCoalesce.n, config.coalesceNMin, config.coalesceNMax); // NO_CHANGE => max
+		rxCoalesce.n = clamp(rxCoalesce.n, config.coalesceNMin, config.coalesceNMax);
+		txCoalesce.delay = clamp(txCoalesce.delay, config.coalesceDelayMin, config.coalesceDelayMax);
+		rxCoalesce.delay = clamp(rxCoalesce.delay, config.coalesceDelayMin, config.coalesceDelayMax);
+	}
+
+	stats.tx.nHwBdsMin = stats.rx.nHwBdsMin = 0xFFFFFFFF;
 	acquireBDRings();
 }
 
@@ -51,14 +65,15 @@ void dmaFeedBase::acquireBDRings(){
 	XAxiDma_BdClear(&bdTemplate);
 
 	// calculate number of BDs that fit into space
-	u32 nTxBd = XAxiDma_BdRingCntCalc(XAXIDMA_BD_MINIMUM_ALIGNMENT, nBytesAllocTxBd);
-	u32 nRxBd = XAxiDma_BdRingCntCalc(XAXIDMA_BD_MINIMUM_ALIGNMENT, nBytesAllocRxBd);
+	u32 nTxBd = nTxBdRing ? nTxBdRing : XAxiDma_BdRingCntCalc(XAXIDMA_BD_MINIMUM_ALIGNMENT, nBytesAllocTxBd);
+	u32 nRxBd = nRxBdRing ? nRxBdRing : XAxiDma_BdRingCntCalc(XAXIDMA_BD_MINIMUM_ALIGNMENT, nBytesAllocRxBd);
 
 	XAxiDma_Config* dmaConf = XAxiDma_LookupConfig(config.dmaDevId);
 	assert(dmaConf && "failed to locate DMA");
 
 	XAxiDma_CfgInitialize(&iDma, dmaConf);
 	assert(XAxiDma_HasSg(&iDma) && "need scatter-gather DMA, got simple mode\r\n");
+	assert(((int)config.nRxChannels <= iDma.RxNumChannels) && "DMA has fewer S2MM channels than nRxChannels");
 
 	txRingPtr = XAxiDma_GetTxRing(&iDma);
 	rxRingPtr = XAxiDma_GetRxRing(&iDma);
@@ -66,38 +81,54 @@ void dmaFeedBase::acquireBDRings(){
 	interruptsDmaOnOff(false); // sample code explicitly disables BdRing interrupts before config
 
 	// === Tx ===
-	s = XAxiDma_BdRingCreate(txRingPtr, /*phys. address*/(UINTPTR)txBdBufSpace, /*virt. address*/(UINTPTR)txBdBufSpace, XAXIDMA_BD_MINIMUM_ALIGNMENT, nTxBd);
-	assert (s == XST_SUCCESS && "DMA Tx BdRingCreate() failed");
+	// unused channel: ring stays empty as initialized (no BDs, free or in hardware)
+	if (config.useTx){
+		s = XAxiDma_BdRingCreate(txRingPtr, /*phys. address*/(UINTPTR)txBdBufSpace, /*virt. address*/(UINTPTR)txBdBufSpace, XAXIDMA_BD_MINIMUM_ALIGNMENT, nTxBd);
+		assert (s == XST_SUCCESS && "DMA Tx BdRingCreate() failed");
 
-	s = XAxiDma_BdRingClone(txRingPtr, &bdTemplate);
-	assert (s == XST_SUCCESS && "DMA Tx BdRingClone() failed");
+		s = XAxiDma_BdRingClone(txRingPtr, &bdTemplate);
+		assert (s == XST_SUCCESS && "DMA Tx BdRingClone() failed");
+	}
 
-	// === RX ===
-	s = XAxiDma_BdRingCreate(rxRingPtr, /*phys. address*/(UINTPTR)rxBdBufSpace, /*virt. address*/(UINTPTR)rxBdBufSpace, XAXIDMA_BD_MINIMUM_ALIGNMENT, nRxBd);
-	assert (s == XST_SUCCESS && "DMA Rx BdRingCreate() failed");
+	// === RX (one ring per channel) ===
+	for (unsigned int ix = 0; config.useRx && (ix < config.nRxChannels); ++ix){
+		UINTPTR ringSpace = (UINTPTR)rxBdBufSpace + ix * nBytesAllocRxBd;
+		s = XAxiDma_BdRingCreate(getRxRing(ix), /*phys. address*/ringSpace, /*virt. address*/ringSpace, XAXIDMA_BD_MINIMUM_ALIGNMENT, nRxBd);
+		assert (s == XST_SUCCESS && "DMA Rx BdRingCreate() failed");
 
-	s = XAxiDma_BdRingClone(rxRingPtr, &bdTemplate);
-	assert (s == XST_SUCCESS && "DMA Rx BdRingClone() failed");
-	BDRingsAreUp = true;
-}
+		s = XAxiDma_BdRingClone(getRxRing(ix), &bdTemplate);
+		assert (s == XST_SUCCESS && "DMA Rx BdRingClone() failed");
+	}
 
-void dmaFeedBase::installGlobalIrqExceptionHandler(){
-	Xil_ExceptionInit();
-#ifdef DMAFEED_HAS_INTC
-	Xil_ExceptionRegisterHandler(XIL_EXCEPTION_ID_INT, (Xil_ExceptionHandler)XIntc_InterruptHandler, (void *)&iIntc);
-#endif
-#ifdef DMAFEED_HAS_SCUGIC
-	Xil_ExceptionRegisterHandler(XIL_EXCEPTION_ID_INT, (Xil_ExceptionHandler)XScuGic_InterruptHandler, (void *)&iIntc);
-#endif
-	Xil_ExceptionEnable();
+	// === cyclic Rx (DMA control register bit, cleared by the reset above) ===
+	if (config.rxCyclic){
+		s = XAxiDma_SelectCyclicMode(&iDma, XAXIDMA_DEVICE_TO_DMA, TRUE);
+		assert (s == XST_SUCCESS && "DMA Rx SelectCyclicMode() failed");
+
+		s = XAxiDma_BdRingEnableCyclicDMA(rxRingPtr);
+		assert (s == XST_SUCCESS && "DMA Rx BdRingEnableCyclicDMA() failed");
+	}
+	BDRingsAreUp = true;
 }
 
-void dmaFeedBase::done(){
+void dmaFeedBase::done(bool rxLeftArmed){
 	assert(!doneFlag);
 
+#if DMAFEED_STATS
+	XTime now;
+	XTime_GetTime(&now);
+	u64 dt = now - tStart;
+	++stats.nTransactions;
+	++stats.latencyHist[dmaFeedIsr::histBin(dt * 1000000 / COUNTS_PER_SECOND)];
+	if (dt > stats.latencyMax)
+		stats.latencyMax = dt;
+#endif
+	trace(dmaTrace::TRACE_DONE, /*isRx*/false);
+
 	XAxiDma_Bd *firstBdPtr;
-	assert(!XAxiDma_BdRingFromHw(txRingPtr, /*no limit to the number of returned BDs*/XAXIDMA_ALL_BDS, &firstBdPtr) && "done() called with uncollected Tx RBs in DMA hardware"); // BdRingFromHw is free of side effects as long as it returns 0
-	assert(!XAxiDma_BdRingFromHw(rxRingPtr, /*no limit to the number of returned BDs*/XAXIDMA_ALL_BDS, &firstBdPtr) && "done() called with uncollected Rx RBs in DMA hardware"); // BdRingFromHw is free of side effects as long as it returns 0
+	assert((!config.useTx || !XAxiDma_BdRingFromHw(txRingPtr, /*no limit to the number of returned BDs*/XAXIDMA_ALL_BDS, &firstBdPtr)) && "done() called with uncollected Tx RBs in DMA hardware"); // BdRingFromHw is free of side effects as long as it returns 0
+	for (unsigned int ix = 0; config.useRx && !rxLeftArmed && (ix < config.nRxChannels); ++ix)
+		assert(!XAxiDma_BdRingFromHw(getRxRing(ix), /*no limit to the number of returned BDs*/XAXIDMA_ALL_BDS, &firstBdPtr) && "done() called with uncollected Rx RBs in DMA hardware"); // BdRingFromHw is free of side effects as long as it returns 0
 
 	doneFlag = true;
 }
@@ -112,112 +143,235 @@ void dmaFeedBase::interruptsDmaOnOff(bool newState){
 		return;
 	int s; // generic status
 	if (newState){
-		// configure DMA end IRQ coalescing
-		s = XAxiDma_BdRingSetCoalesce(txRingPtr, config.coalesceNTxInterrupts, config.coalesceDelayTx); assert (s == XST_SUCCESS && "DMA Tx BdRingSetCoalesce() failed");
-		s = XAxiDma_BdRingSetCoalesce(rxRingPtr, config.coalesceNRxInterrupts, config.coalesceDelayRx); assert (s == XST_SUCCESS && "DMA Rx BdRingSetCoalesce() failed");
-
+		// configure DMA end IRQ coalescing (S2MM control register is common to all Rx rings)
 		// enable interrupts on DMA end
 		// - config leaves them disabled
 		// - reset() in error case disables all interrupts
-		XAxiDma_BdRingIntEnable(txRingPtr, XAXIDMA_IRQ_ALL_MASK);
-		XAxiDma_BdRingIntEnable(rxRingPtr, XAXIDMA_IRQ_ALL_MASK);
+		// => an unused channel keeps them disabled
+		if (config.useTx){
+			s = XAxiDma_BdRingSetCoalesce(txRingPtr, txCoalesce.n, txCoalesce.delay); assert (s == XST_SUCCESS && "DMA Tx BdRingSetCoalesce() failed");
+			XAxiDma_BdRingIntEnable(txRingPtr, XAXIDMA_IRQ_ALL_MASK);
+		}
+		if (config.useRx){
+			s = XAxiDma_BdRingSetCoalesce(rxRingPtr, rxCoalesce.n, rxCoalesce.delay); assert (s == XST_SUCCESS && "DMA Rx BdRingSetCoalesce() failed");
+			XAxiDma_BdRingIntEnable(rxRingPtr, XAXIDMA_IRQ_ALL_MASK);
+		}
 	} else /* if (!newState) */{
-		XAxiDma_BdRingIntDisable(txRingPtr, XAXIDMA_IRQ_ALL_MASK);
-		XAxiDma_BdRingIntDisable(rxRingPtr, XAXIDMA_IRQ_ALL_MASK);
+		if (config.useTx)
+			XAxiDma_BdRingIntDisable(txRingPtr, XAXIDMA_IRQ_ALL_MASK);
+		if (config.useRx)
+			XAxiDma_BdRingIntDisable(rxRingPtr, XAXIDMA_IRQ_ALL_MASK);
 	}
 	DMAsideInterruptsAreUp = newState;
 }
 
-#ifdef DMAFEED_HAS_INTC
 void dmaFeedBase::interruptsIrcOnOff(bool newState){
-	if (newState == IRCSideInterruptsAreUp)
+	if (newState == IRCsideInterruptsAreUp)
 		return;
 	if (newState){
-		s = XIntc_Initialize(&iIntCtrl, DMAFEED_INTC_DEVICE_ID); assert(s == XST_SUCCESS && "XIntc_Initialize() failed");
-
-		s = XIntc_Connect(&iIntCtrl, config.txIntrId, (XInterruptHandler) txInterruptCallback, /*payload arg*/this); assert(s == XST_SUCCESS && "XIntc_Connect(Tx) failed");
-		s = XIntc_Connect(&iIntCtrl, config.rxIntrId, (XInterruptHandler) rxInterruptCallback, /*payload arg*/this); assert(s == XST_SUCCESS && "XIntc_Connect(Rx) failed");
-
-		s = XIntc_Start(&iIntCtrl, XIN_REAL_MODE); assert(s == XST_SUCCESS && "XIntc_Start() failed");
-
-		XIntc_Enable(&iIntCtrl, config.txIntrId);
-		XIntc_Enable(&iIntCtrl, config.rxIntrId);
+		bool deferred = (config.completionMode == dmaFeedBaseConfig::DMAFEED_COMPLETION_DEFERRED);
+		if (config.useTx)
+			dmaFeedIntc::connect(config.txIntrId, deferred ? (Xil_InterruptHandler)txDeferredCallback : txCallback, /*payload arg*/this, config.irqCpu);
+		if (config.useRx)
+			dmaFeedIntc::connect(config.rxIntrId, deferred ? (Xil_InterruptHandler)rxDeferredCallback : rxCallback, /*payload arg*/this, config.irqCpu);
 	} else /* if (!newState) */{
-		XIntc_Disconnect(IntcInstancePtr, config.txIntrId);
-		XIntc_Disconnect(IntcInstancePtr, config.rxIntrId);
+		if (config.useTx)
+			dmaFeedIntc::disconnect(config.txIntrId);
+		if (config.useRx)
+			dmaFeedIntc::disconnect(config.rxIntrId);
 	}
 	IRCsideInterruptsAreUp = newState;
 }
+
+void dmaFeedBase::runStart(){
+	// a late (e.g. delay timer) interrupt from the previous transaction passes the doneFlag check from here on
+	// => must not preempt setup and the first queue() call
+	Xil_ExceptionDisable();
+	doneFlag = false;
+	dmaError = false;
+#if DMAFEED_STATS
+	XTime_GetTime(&tStart);
 #endif
+	trace(dmaTrace::TRACE_RUN_START, /*isRx*/false);
 
-#ifdef DMAFEED_HAS_SCUGIC
-void dmaFeedBase::interruptsIrcOnOff(bool newState){
-	if (newState == IRCsideInterruptsAreUp)
-		return;
+	acquireBDRings();
+
+	// === enable callback ===
+	// note: edge sensitive => must enable before starting
+	txCoalesce.tLastIrq = 0;
+	rxCoalesce.tLastIrq = 0;
+	pollingActive = (config.completionMode == dmaFeedBaseConfig::DMAFEED_COMPLETION_POLL) || (config.completionMode == dmaFeedBaseConfig::DMAFEED_COMPLETION_HYBRID);
+	nIdlePolls = 0;
+	txPendingIrq = 0; // status of the previous transaction
+	rxPendingIrq = 0;
+	interruptsOnOff(!pollingActive);
+
+	// === start channels ===
+	// before queueing: BdRingStart() (re)writes the tail pointer if BDs are in hardware. If the engine already finished those
+	// (short transfer), the repeated tail write would restart it into unqueued BDs. Queueing into a running ring is safe.
+	// A ring still running from the last transaction (BDs left armed, e.g. adopted with rxCompleteOnEof) is not started again
+	// for the same reason. An unused channel stays halted
 	int s; // generic state
-	if (newState){
-		XScuGic_Config *intcConfig = XScuGic_LookupConfig(DMAFEED_INTC_DEVICE_ID); assert(intcConfig && "DMA: XScuGic_LookupConfig() failed");
-		s = XScuGic_CfgInitialize(&iIntc, intcConfig, intcConfig->CpuBaseAddress); assert(s == XST_SUCCESS && "DMA: XScuGic_CfgInitialize() failed");
+	if (config.useTx && (txRingPtr->RunState != AXIDMA_CHANNEL_NOT_HALTED)){
+		s = XAxiDma_BdRingStart(txRingPtr); assert(s == XST_SUCCESS && "DMA Tx: BdRingStart() failed");
+	}
+	for (unsigned int ix = 0; config.useRx && (ix < config.nRxChannels); ++ix){
+		if (getRxRing(ix)->RunState == AXIDMA_CHANNEL_NOT_HALTED)
+			continue;
+		s = XAxiDma_BdRingStart(getRxRing(ix)); assert(s == XST_SUCCESS && "DMA Rx: BdRingStart() failed");
+	}
+
+	// === queue first BDs, starts transfer ===
+	serviceQueue<virtualDispatch>(/*txEvent*/config.useTx, /*rxEvent*/config.useRx, /*afterCollect*/false); // Tx and Rx RBs of used channels are available
+	Xil_ExceptionEnable();
+}
 
-		XScuGic_SetPriorityTriggerType(&iIntc, config.txIntrId, /*prio*/0xA0, /*rising edge*/0x3); // prio value from sample code
-		XScuGic_SetPriorityTriggerType(&iIntc, config.rxIntrId, /*prio*/0xA0, /*rising edge*/0x3);
+void dmaFeedBase::resetDma(){
+	// Dma_Reset(): "Any DMA transaction in progress will finish gracefully before engine starts reset.
+	// Any other transactions that have been submitted to hardware will be discarded by the hardware."
 
-		s = XScuGic_Connect(&iIntc, config.txIntrId, (Xil_InterruptHandler)txInterruptCallback, /*payload arg*/this); assert(s == XST_SUCCESS && "DMA: XScuGic_Connect() failed for txInt");
-		s = XScuGic_Connect(&iIntc, config.rxIntrId, (Xil_InterruptHandler)rxInterruptCallback, /*payload arg*/this); assert(s == XST_SUCCESS && "DMA: XScuGic_Connect() failed for rxInt");
+	// reset() disables interrupts on DMA end => need to re-enable on next transaction
+	DMAsideInterruptsAreUp = false;
 
-		XScuGic_Enable(&iIntc, config.txIntrId);
-		XScuGic_Enable(&iIntc, config.rxIntrId);
-	} else /* if (!newState) */{
-		XScuGic_Disconnect(&iIntc, config.txIntrId);
-		XScuGic_Disconnect(&iIntc, config.rxIntrId);
+	// "all transactions finished" implies all buffers are free - partly complete - after reset.
+	BDRingsAreUp = false; // let's not trust this and rebuild BD rings ...
+	trace(dmaTrace::TRACE_RESET, /*isRx*/false);
+
+	// sample code implies reset may fail. Not sure what to do about this...
+	for (int retry = 0; retry < 5; ++retry){
+		XAxiDma_Reset(&iDma);
+
+		for (unsigned int ix = 0; ix < 10000; ++ix)
+			if (XAxiDma_ResetIsDone(&iDma))
+				return;
 	}
-	IRCsideInterruptsAreUp = newState;
+	assert(0 && "failed to reset DMA"); // -DNDEBUG will continue like the sample code
 }
-#endif
 
-void dmaFeedBase::runStart(){
-	doneFlag = false;
-	dmaError = false;
+void dmaFeedBase::setRingBdCounts(u32 nTxBd, u32 nRxBd){
+	assert((nTxBd <= XAxiDma_BdRingCntCalc(XAXIDMA_BD_MINIMUM_ALIGNMENT, nBytesAllocTxBd)) && "Tx ring exceeds BD memory (nBytesAllocTxBd)");
+	assert((nRxBd <= XAxiDma_BdRingCntCalc(XAXIDMA_BD_MINIMUM_ALIGNMENT, nBytesAllocRxBd)) && "Rx ring exceeds BD memory (nBytesAllocRxBd)");
+	if ((nTxBd == nTxBdRing) && (nRxBd == nRxBdRing))
+		return;
+	assert((!BDRingsAreUp || (!getTxHwCnt() && !getRxHwCnt())) && "setRingBdCounts() with BDs in hardware"); // after reset: rebuilt anyway
+	nTxBdRing = nTxBd;
+	nRxBdRing = nRxBd;
+	if (BDRingsAreUp){
+		interruptsOnOff(false);
+		resetDma(); // rebuilds rings on next runStart()
+	}
+}
 
-	acquireBDRings();
+void dmaFeedBase::abort(){
+	interruptsOnOff(false);
+	resetDma();
+	dmaError = false;
+	doneFlag = true;
+}
 
-	// === enable callback ===
-	// note: edge sensitive => must enable before starting
-	interruptsOnOff(true);
+bool dmaFeedBase::pollService(){
+	// IRQ status bits latch with interrupts disabled: used for error and completion detection
+	u32 txIrqStatus = config.useTx ? XAxiDma_BdRingGetIrq(txRingPtr) : 0;
+	u32 rxIrqStatus = config.useRx ? XAxiDma_BdRingGetIrq(rxRingPtr) : 0;
+	if (txIrqStatus)
+		XAxiDma_BdRingAckIrq(txRingPtr, txIrqStatus);
+	if (rxIrqStatus)
+		XAxiDma_BdRingAckIrq(rxRingPtr, rxIrqStatus);
+	return serviceRings(txIrqStatus, rxIrqStatus, /*deferred*/false);
+}
 
-	// === queue first BDs ===
-	queue(/*txEvent*/true, /*rxEvent*/true); // both Tx and Rx RBs are available
+void dmaFeedBase::txDeferredCallback(dmaFeedBase* self){
+	self->deferIrq(self->txRingPtr, self->txPendingIrq, self->stats.tx, /*isRx*/false);
+}
 
-	// === start transfer ===
-	int s; // generic state
-	s = XAxiDma_BdRingStart(txRingPtr);	assert(s == XST_SUCCESS && "DMA Tx: BdRingStart() failed");
-	s = XAxiDma_BdRingStart(rxRingPtr); assert(s == XST_SUCCESS && "DMA Rx: BdRingStart() failed");
+void dmaFeedBase::rxDeferredCallback(dmaFeedBase* self){
+	self->deferIrq(self->rxRingPtr, self->rxPendingIrq, self->stats.rx, /*isRx*/true);
 }
 
-dmaFeedBase::run_poll_e dmaFeedBase::run_poll(){
-	if (dmaError){
-		// Dma_Reset(): "Any DMA transaction in progress will finish gracefully before engine starts reset.
-		// Any other transactions that have been submitted to hardware will be discarded by the hardware."
+void dmaFeedBase::deferIrq(XAxiDma_BdRing* ringPtr, std::atomic<u32>& pending, channelStats_t& st, bool isRx){
+	dmaFeedIsr::statsTimer<DMAFEED_STATS> t(st.isrTime);
+	if (DMAFEED_STATS)
+		++st.nInterrupts;
 
-		// reset() disables interrupts on DMA end => need to re-enable on next transaction
-		DMAsideInterruptsAreUp = false;
+	u32 irqStatus = XAxiDma_BdRingGetIrq(ringPtr);
+	XAxiDma_BdRingAckIrq(ringPtr, irqStatus);
+	dmaFeedIsr::traceIrq tr(config.dmaDevId, isRx, irqStatus);
+
+	if (!(irqStatus & XAXIDMA_IRQ_ALL_MASK) || doneFlag)
+		return; // nothing to do, or late (delay timer) interrupt after completion
+
+	// errors, too: the bottom half handles them like pollService()
+	pending |= irqStatus;
+	if (config.deferredNotify)
+		config.deferredNotify(config.deferredNotifyContext);
+}
+
+bool dmaFeedBase::deferredService(){
+	// take the status recorded so far, interrupts from here on go to the next pass
+	Xil_ExceptionDisable();
+	u32 txIrqStatus = txPendingIrq;
+	u32 rxIrqStatus = rxPendingIrq;
+	txPendingIrq = 0;
+	rxPendingIrq = 0;
+	Xil_ExceptionEnable();
+	if (!(txIrqStatus | rxIrqStatus))
+		return false; // no interrupt since the last pass => rings unchanged as far as coalescing tells, skip
+	return serviceRings(txIrqStatus, rxIrqStatus, /*deferred*/true);
+}
 
-		// "all transactions finished" implies all buffers are free - partly complete - after reset.
-		BDRingsAreUp = false; // let's not trust this and rebuild BD rings ...
+bool dmaFeedBase::serviceRings(u32 txIrqStatus, u32 rxIrqStatus, bool deferred){
+	if ((txIrqStatus | rxIrqStatus) & XAXIDMA_IRQ_ERROR_MASK){
+		if (txIrqStatus & XAXIDMA_IRQ_ERROR_MASK)
+			trace(dmaTrace::TRACE_ERROR, /*isRx*/false, txIrqStatus);
+		if (rxIrqStatus & XAXIDMA_IRQ_ERROR_MASK)
+			trace(dmaTrace::TRACE_ERROR, /*isRx*/true, rxIrqStatus);
+		dmaError = true;
+		return false;
+	}
 
-		// sample code implies reset may fail. Not sure what to do about this...
-		for (int retry = 0; retry < 5; ++retry){
-			XAxiDma_Reset(&iDma);
+	// collect unconditionally: no dependency on coalescing settings. DEFERRED: one pass for both interrupts, also picks up
+	// BDs of the other channel whose interrupt is still held back by coalescing. Counted as interrupt BDs (stats)
+	int nTxBds = 0;
+	if (config.useTx)
+		nTxBds = serviceTx<virtualDispatch>(/*fromIsr*/deferred);
+	int nRxBds = 0;
+	if (config.useRx && !doneFlag)
+		nRxBds = serviceRx<virtualDispatch>(/*fromIsr*/deferred);
+	if (deferred && config.coalesceAdaptive && !doneFlag){
+		// interrupt interval as seen by the bottom half
+		if (txIrqStatus & (XAXIDMA_IRQ_DELAY_MASK | XAXIDMA_IRQ_IOC_MASK))
+			adaptCoalesce(txRingPtr, txCoalesce, txIrqStatus, nTxBds, stats.tx);
+		if (rxIrqStatus & (XAXIDMA_IRQ_DELAY_MASK | XAXIDMA_IRQ_IOC_MASK))
+			adaptCoalesce(rxRingPtr, rxCoalesce, rxIrqStatus, nRxBds, stats.rx);
+	}
+	// unlike after an interrupt, the ring may still be completely busy => queue() only where BDs were freed
+	if (!doneFlag)
+		serviceQueue<virtualDispatch>(/*txEvent*/getTxFreeCnt() > 0, /*rxEvent*/getRxFreeCnt() > 0, /*afterCollect*/true);
+	return (txIrqStatus | rxIrqStatus) & (XAXIDMA_IRQ_DELAY_MASK | XAXIDMA_IRQ_IOC_MASK);
+}
 
-			for (unsigned int ix = 0; ix < 10000; ++ix)
-				if (XAxiDma_ResetIsDone(&iDma))
-					goto doneWithError;
+dmaFeedBase::run_poll_e dmaFeedBase::run_poll(){
+	if (pollingActive && !doneFlag && !dmaError){
+		if (pollService())
+			nIdlePolls = 0;
+		else if ((config.completionMode == dmaFeedBaseConfig::DMAFEED_COMPLETION_HYBRID) && (++nIdlePolls >= config.hybridSpinBudget) && !doneFlag && !dmaError){
+			// spin budget exhausted: hand over to interrupts. Completions since the last poll are latched in the IRQ status
+			// and fire on DMA side enable => interrupt controller must be ready first
+			pollingActive = false;
+			interruptsIrcOnOff(true);
+			interruptsDmaOnOff(true);
 		}
-		assert(0 && "failed to reset DMA"); // -DNDEBUG will continue like the sample code
-	doneWithError:
+	} else if ((config.completionMode == dmaFeedBaseConfig::DMAFEED_COMPLETION_DEFERRED) && !doneFlag && !dmaError)
+		deferredService();
+
+	if (dmaError){
+		resetDma();
 		// run_poll() reports an error only once
 		dmaError = false;
-		return DMAFEED_IDLE_ERROR;
+		// transaction is over => no queue() from application context (e.g. dmaFeedStream::release()) until next runStart()
+		doneFlag = true;
+		// unless the derived class continues it
+		return onError() ? DMAFEED_BUSY : DMAFEED_IDLE_ERROR;
 	} // if dmaError
 
 	return doneFlag ? DMAFEED_IDLE : DMAFEED_BUSY;
@@ -226,53 +380,87 @@ dmaFeedBase::run_poll_e dmaFeedBase::run_poll(){
 dmaFeedBase::~dmaFeedBase(){
 	// disable interrupts
 	interruptsOnOff(false);
-	free(bufferDescriptorSpace); // from aligned_alloc; free(NULL) is safe
+	if (bdSpaceIsOwned)
+		dmaBdArena::free(bufferDescriptorSpace, nBytesAllocTxBd + config.nRxChannels * nBytesAllocRxBd);
 }
 
-void dmaFeedBase::txInterruptCallback(dmaFeedBase* self){
-	// === get and acknowledge IRQ status ===
-	u32 irqStatus = XAxiDma_BdRingGetIrq(self->txRingPtr);
-	XAxiDma_BdRingAckIrq(self->txRingPtr, irqStatus);
-
-	if (!(irqStatus & XAXIDMA_IRQ_ALL_MASK))
-		return; // nothing to do (shortcut)
-
-	if (self->doneFlag)
-		return; // possible delay interrupt after user code has flagged completion, suppress callbacks
-
-	if ((irqStatus & XAXIDMA_IRQ_ERROR_MASK))
-		self->dmaError = true;
-
-	if (self->dmaError)
-		return; // no user code callbacks in error state, pending reset
-
-	if (!(irqStatus & (XAXIDMA_IRQ_DELAY_MASK | XAXIDMA_IRQ_IOC_MASK)))
-		return;
+int dmaFeedBase::getTxFreeCnt(){
+	return config.useTx ? XAxiDma_BdRingGetFreeCnt(txRingPtr) : 0;
+}
 
-	self->collectTx(); // continue with implementation-specific code to free (and optionally, process) Tx BDs completed by the DMA hardware
-	self->queue(/*txEvent*/true, /*rxEvent*/false);
+u32 dmaFeedBase::getTxHwCnt(){
+	return config.useTx ? txRingPtr->HwCnt : 0;
 }
 
-void dmaFeedBase::rxInterruptCallback(dmaFeedBase* self){
-	// === get and acknowledge IRQ status ===
-	u32 irqStatus = XAxiDma_BdRingGetIrq(self->rxRingPtr);
-	XAxiDma_BdRingAckIrq(self->rxRingPtr, irqStatus);
+int dmaFeedBase::getRxFreeCnt(){
+	int n = 0;
+	for (unsigned int ix = 0; config.useRx && (ix < config.nRxChannels); ++ix)
+		n += XAxiDma_BdRingGetFreeCnt(getRxRing(ix));
+	return n;
+}
 
-	if (!(irqStatus & XAXIDMA_IRQ_ALL_MASK))
-		return; // nothing to do (shortcut)
+u32 dmaFeedBase::getRxHwCnt(){
+	u32 n = 0;
+	for (unsigned int ix = 0; config.useRx && (ix < config.nRxChannels); ++ix)
+		n += getRxRing(ix)->HwCnt;
+	return n;
+}
 
-	if (self->doneFlag)
-		return; // possible delay interrupt after user code has flagged completion, suppress callbacks
+dmaFeedBase::stats_t dmaFeedBase::getStats() const{
+	Xil_ExceptionDisable();
+	stats_t s = stats;
+	Xil_ExceptionEnable();
+	return s;
+}
 
-	if ((irqStatus & XAXIDMA_IRQ_ERROR_MASK))
-		self->dmaError = true;
+void dmaFeedBase::resetStats(){
+	Xil_ExceptionDisable();
+	stats = {};
+	stats.tx.nHwBdsMin = stats.rx.nHwBdsMin = 0xFFFFFFFF;
+	Xil_ExceptionEnable();
+}
 
-	if (self->dmaError)
-		return; // no callbacks in error state, pending reset
+void dmaFeedBase::getCoalesce(u32& nTx, u32& delayTx, u32& nRx, u32& delayRx) const{
+	nTx = txCoalesce.n;
+	delayTx = txCoalesce.delay;
+	nRx = rxCoalesce.n;
+	delayRx = rxCoalesce.delay;
+}
 
-	if (!(irqStatus & (XAXIDMA_IRQ_DELAY_MASK | XAXIDMA_IRQ_IOC_MASK)))
+void dmaFeedBase::adaptCoalesce(XAxiDma_BdRing* ringPtr, coalesce_t& c, u32 irqStatus, int nBds, channelStats_t& st){
+	XTime now;
+	XTime_GetTime(&now);
+	XTime tLast = c.tLastIrq;
+	c.tLastIrq = now;
+	if (!nBds)
+		return; // status latched for BDs already collected (HYBRID), no information
+
+	u32 n = c.n;
+	u32 delay = c.delay;
+	if (irqStatus & XAXIDMA_IRQ_IOC_MASK){
+		// count reached: batch more while the interrupt rate is too high
+		XTime minInterval = (XTime)config.coalesceMinIrqInterval_us * COUNTS_PER_SECOND / 1000000;
+		if (tLast && (now - tLast < minInterval)){
+			n = clamp(2 * n, config.coalesceNMin, config.coalesceNMax);
+			delay = clamp(2 * delay, config.coalesceDelayMin, config.coalesceDelayMax);
+		}
+	} else if (irqStatus & XAXIDMA_IRQ_DELAY_MASK){
+		// delay timer expired before count was reached: count too high for the current rate, costs latency
+		n = clamp(n / 2, config.coalesceNMin, config.coalesceNMax);
+		delay = clamp(delay / 2, config.coalesceDelayMin, config.coalesceDelayMax);
+	}
+	if ((n == c.n) && (delay == c.delay))
 		return;
 
-	self->collectRx(); // continue with implementation-specific code to free (and optionally, process) Rx BDs completed by the DMA hardware
-	self->queue(/*txEvent*/false, /*rxEvent*/true);
+#if DMAFEED_STATS
+	if (n > c.n)
+		++st.nCoalesceUp;
+	else
+		++st.nCoalesceDown;
+#else
+	(void)st;
+#endif
+	c.n = n;
+	c.delay = delay;
+	int s = XAxiDma_BdRingSetCoalesce(ringPtr, n, delay); assert (s == XST_SUCCESS && "DMA BdRingSetCoalesce() failed"); (void)s;
 }
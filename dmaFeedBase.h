@@ -6,22 +6,37 @@
 #include "xil_exception.h"
 
 #include <cassert>
-#include "xscugic.h"
+#include <atomic>
+#include "dmaFeedIntc.h"
+#include "dmaTrace.h"
+#include "xtime_l.h"
 
-// === determine type of interrupt controller ===
-#ifdef XPAR_INTC_0_DEVICE_ID
-#	define DMAFEED_HAS_INTC
-#	define DMAFEED_INTC_DEVICE_ID          XPAR_INTC_0_DEVICE_ID
-#	include "xscugic.h" // TBD update
-#else
-#	define DMAFEED_HAS_SCUGIC
-#	define DMAFEED_INTC_DEVICE_ID          XPAR_SCUGIC_SINGLE_DEVICE_ID
-#	include "xscugic.h"
+// compile with -DDMAFEED_STATS=1 to count interrupts, BDs, bytes and time spent in interrupt callbacks (see dmaFeedBase::getStats())
+#ifndef DMAFEED_STATS
+#	define DMAFEED_STATS 0
+#endif
+// number of bins of the power-of-two histograms in dmaFeedBase::stats_t
+#ifndef DMAFEED_STATS_NBINS
+#	define DMAFEED_STATS_NBINS 16
 #endif
 
 // all fields may be optionally configured before passing to dmaFeed constructor
 class dmaFeedBaseConfig{
 public:
+	typedef enum {
+		// completed BDs are collected by Tx / Rx interrupt callbacks
+		DMAFEED_COMPLETION_IRQ=0,
+
+		// interrupts stay disabled, run_poll() collects completed BDs and queues new ones
+		DMAFEED_COMPLETION_POLL,
+
+		// as POLL, but falls back to IRQ for the rest of the transaction after hybridSpinBudget run_poll() calls without completion
+		DMAFEED_COMPLETION_HYBRID,
+
+		// interrupt callbacks only acknowledge and record the IRQ status (and call deferredNotify). The bottom half in run_poll()
+		// then collects both rings and queues in one pass, outside interrupt context
+		DMAFEED_COMPLETION_DEFERRED} completion_e;
+
 	dmaFeedBaseConfig(unsigned int dmaDevId, unsigned int txIntrId, unsigned int rxIntrId) :
 		dmaDevId(dmaDevId), txIntrId(txIntrId), rxIntrId(rxIntrId){}
 	u32 dmaDevId;
@@ -35,13 +50,65 @@ public:
 	unsigned int coalesceDelayTx = XAXIDMA_NO_CHANGE;
 	// delay for Rx interrupt when coalesce count is not reached in time in units of C_DLYTMR_RESOLUTION clock cycles (DMA option)
 	unsigned int coalesceDelayRx = XAXIDMA_NO_CHANGE;
+	// adaptive coalescing: interrupt callbacks retune count and delay of each channel within the bounds below, starting from
+	// coalesceN*Interrupts / coalesceDelay* (clamped). Count and delay are doubled while completion interrupts (count reached)
+	// come faster than coalesceMinIrqInterval_us, and halved when the delay timer fires first (traffic too slow for the count).
+	bool coalesceAdaptive = false;
+	unsigned int coalesceNMin = 1;
+	unsigned int coalesceNMax = 64; // up to 255 (DMA register width)
+	unsigned int coalesceDelayMin = 1; // nonzero, a count above 1 without delay would never interrupt on the last packets
+	unsigned int coalesceDelayMax = 64; // up to 255 (DMA register width)
+	unsigned int coalesceMinIrqInterval_us = 20;
+	// how completed BDs are detected (see completion_e)
+	completion_e completionMode = DMAFEED_COMPLETION_IRQ;
+	// DMAFEED_COMPLETION_HYBRID: consecutive run_poll() calls without completion before enabling interrupts
+	unsigned int hybridSpinBudget = 1000;
+	// DMAFEED_COMPLETION_DEFERRED: optional wake-up of the thread / loop that calls run_poll(), in interrupt context after
+	// recording a completion or error status
+	void (*deferredNotify)(void* context) = NULL;
+	void* deferredNotifyContext = NULL;
+	// CPU that takes the Tx / Rx interrupts (SCUGIC, see dmaFeedIntc::connect()), -1: as the interrupt controller has it
+	// - all methods of the instance must be called on that CPU: they lock out the interrupt callbacks with
+	//   Xil_ExceptionDisable(), which masks the calling CPU only (see dmaServiceCore for other cores)
+	// - checked against XPAR_CPU_ID where the BSP defines it
+	int irqCpu = -1;
+	// sizes both rings for transactions of nBytes split into maxPacketSize chunks: one BD per chunk, within nBdsMin..nBdsMax
+	// (a ring smaller than the transaction is refilled from the interrupt callbacks)
+	void sizeRings(u32 nBytes, u32 maxPacketSize, u32 nBdsMin = 16, u32 nBdsMax = 2048){
+		u32 nBds = nBytes / maxPacketSize + (nBytes % maxPacketSize ? 1 : 0);
+		nBds = (nBds < nBdsMin) ? nBdsMin : (nBds > nBdsMax) ? nBdsMax : nBds;
+		nBytesAllocTxBd = nBds * XAXIDMA_BD_MINIMUM_ALIGNMENT;
+		nBytesAllocRxBd = nBds * XAXIDMA_BD_MINIMUM_ALIGNMENT;
+	}
+	// memory for Tx buffer descriptors, determines Tx ring size (DMA SG sample code uses 64k)
+	u32 nBytesAllocTxBd = 0x10000;
+	// memory for Rx buffer descriptors, determines Rx ring size (DMA SG sample code uses 64k), per Rx channel
+	u32 nBytesAllocRxBd = 0x10000;
+	// S2MM channels of a DMA built with multichannel support: Rx ring ix receives the packets with TDEST ix.
+	// Interrupt, coalescing and error status belong to the S2MM channel as a whole => shared by all rings.
+	// Derived classes other than dmaFeedStream use one channel.
+	u32 nRxChannels = 1;
+	// S2MM cyclic BD mode: once started, the hardware follows the Rx ring links endlessly, ignoring the tail pointer and the
+	// complete bit of the BDs it overwrites. The derived class arms the whole ring once and never collects (see dmaFeedCyclic).
+	// One Rx channel only.
+	bool rxCyclic = false;
+	// channels in use (at least one). An unused channel gets no BD ring or BD memory, its interrupt is neither enabled nor
+	// connected (its interrupt ID is ignored), and collectTx() / collectRx() / queue() of the derived class are never called for
+	// it. E.g. MM2S playout or S2MM capture with dmaFeedBasic; dmaFeedStream and dmaFeedCyclic are Rx only
+	// The engine is still initialized and reset as a whole (XAxiDma_CfgInitialize() when the rings are built, error recovery,
+	// abort()): the hardware has one reset for both channels => one instance per engine, the unused channel stays idle
+	bool useTx = true;
+	bool useRx = true;
+	// optional memory for all BD rings (nBytesAllocTxBd + nRxChannels * nBytesAllocRxBd bytes, without the unused channel, BD
+	// aligned, uncached or coherent), e.g. from a dmaBufferPool with DMAPOOL_UNCACHED. NULL: from the shared dmaBdArena
+	void* bdSpace = NULL;
 };
 
 // dmaFeed sends and receives a predetermined amount of data on a given DMA channel
 class dmaFeedBase{
 public:
 	dmaFeedBase(const dmaFeedBaseConfig& config);
-	~dmaFeedBase();
+	virtual ~dmaFeedBase();
 	typedef enum {
 		// freshly initialized or transaction has completed
 		DMAFEED_IDLE=0,
@@ -53,8 +120,59 @@ public:
 		DMAFEED_IDLE_ERROR} run_poll_e;
 	run_poll_e run_poll();
 
+	// DMAFEED_COMPLETION_DEFERRED: interrupts have recorded status that the bottom half (next run_poll()) has not handled yet.
+	// A servicing loop may sleep while false (until deferredNotify)
+	bool servicePending() const {return txPendingIrq || rxPendingIrq;}
 	// installs the global library-default exception handler for interrupts (once per application if not done elsewhere)
-	static void installGlobalIrqExceptionHandler();
+	// see dmaFeedIntc
+	static void installGlobalIrqExceptionHandler(){dmaFeedIntc::installGlobalIrqExceptionHandler();}
+
+	// statistics of one direction (Rx: all channels together), see stats_t
+	typedef struct {
+		// number of tx- / rxInterruptCallback() invocations
+		u32 nInterrupts;
+		// time spent in the interrupt callback in XTime_GetTime() units (COUNTS_PER_SECOND)
+		u64 isrTime;
+		// BDs freed by collectTx() / collectRx() in the interrupt callback, or in the bottom half with DEFERRED completion
+		// (nBds / nInterrupts: BDs per interrupt)
+		u32 nBds;
+		// histogram of BDs freed per interrupt (DEFERRED: per bottom half pass): bin 0 counts interrupts without BD, bin k
+		// 2^(k-1) .. 2^k - 1 BDs (last bin: more)
+		u32 bdsPerIrq[DMAFEED_STATS_NBINS];
+		// BDs freed by collectTx() / collectRx() in run_poll() (polling modes)
+		u32 nPolledBds;
+		// payload bytes of completed BDs, as reported by the derived class
+		u64 nBytes;
+		// high-water mark: most BDs in hardware after queue()
+		u32 nHwBdsMax;
+		// low-water mark: fewest BDs left in hardware after collecting (0xFFFFFFFF: not serviced yet)
+		u32 nHwBdsMin;
+		// the ring had run dry (no BD left in hardware, engine idle) when serviced, and queue() had more work for it
+		u32 nDry;
+		// adaptive coalescing decisions: count and delay raised / lowered
+		u32 nCoalesceUp;
+		u32 nCoalesceDown;
+	} channelStats_t;
+
+	// statistics, counted only if compiled with DMAFEED_STATS (otherwise all zero)
+	typedef struct {
+		channelStats_t tx;
+		channelStats_t rx;
+		// time spent in collectTx() / collectRx() and in queue() of the derived class (interrupt callbacks, run_poll(), runStart())
+		u64 collectTime;
+		u64 queueTime;
+		// transactions completed by done(), and their duration from runStart(): histogram over microseconds, bin 0: below 1 us,
+		// bin k: 2^(k-1) .. 2^k - 1 us (last bin: more). Continuous classes (dmaFeedStream, -Jobs, -Packet) never call done().
+		u32 nTransactions;
+		u32 latencyHist[DMAFEED_STATS_NBINS];
+		u64 latencyMax;
+	} stats_t;
+	// consistent snapshot (masks interrupts while copying)
+	stats_t getStats() const;
+	void resetStats();
+
+	// current coalescing count and delay (tracks adaptive changes, see dmaFeedBaseConfig::coalesceAdaptive)
+	void getCoalesce(u32& nTx, u32& delayTx, u32& nRx, u32& delayRx) const;
 
 protected: // custom derived class would override collectTx(), collectRx(), queue(), needs access to those:
 	// user class provides public method
@@ -66,7 +184,7 @@ protected: // custom derived class would override collectTx(), collectRx(), queu
 	virtual void collectTx() = 0;
 
 	// application-specific code, called by interrupt
-	// - frees RBs returned from hardware, if any
+	// - frees RBs returned from hardware, if any (from all getRxRing() rings with nRxChannels > 1: they share the interrupt)
 	// - eventually, any one of user methods "collectTx(), collectRx(), queue()" must flag completion by calling done() at a time when all RBs have been received and free()d.
 	virtual void collectRx() = 0;
 
@@ -81,8 +199,39 @@ protected: // custom derived class would override collectTx(), collectRx(), queu
 	// will be recalled on error (do not allocate here, use constructor instead)
 	virtual void acquireBDRings();
 
+	// called by run_poll() after a DMA error, with the engine reset and the transaction ended. A derived class may continue the
+	// transaction here (rebuild the rings and queue again, see dmaFeedBasicConfig::resumeMaxRetries) and return true: run_poll()
+	// then returns DMAFEED_BUSY instead of DMAFEED_IDLE_ERROR
+	virtual bool onError(){return false;}
+
 	// any one of user methods "collectTx(), collectRx(), queue()" must flag completion by calling done() at a time when all RBs have been received and free()d.
-	void done();
+	// rxLeftArmed: Rx BDs stay in hardware on purpose (dmaFeedBasicConfig::rxCompleteOnEof) => no check of the Rx rings, a later
+	// packet may complete those BDs at any time
+	void done(bool rxLeftArmed = false);
+
+	// sizes the rings to nTxBd / nRxBd BDs (0: as many as fit the BD memory), e.g. to hold exactly one transaction.
+	// Between transactions, with no BDs in hardware (see abort()). Rebuilds the rings (DMA reset) on the next runStart() if changed
+	void setRingBdCounts(u32 nTxBd, u32 nRxBd);
+
+	// whether the BD rings are configured on the DMA. false after construction, resizing, error or abort(): the next runStart()
+	// rebuilds them from the template BD (acquireBDRings()), BD contents are lost
+	bool bdRingsAreUp() const {return BDRingsAreUp;}
+
+	// ends a transaction that still has BDs in hardware (e.g. permanently armed Rx buffers): disables interrupts, resets the DMA
+	// and flags completion. BD rings are rebuilt on next runStart(). Call outside interrupt context.
+	void abort();
+
+	// collectTx() / collectRx() report payload bytes of completed BDs for stats_t::channelStats_t::nBytes (no-op without DMAFEED_STATS)
+	void statsBytes(bool isRx, u32 nBytes){
+#if DMAFEED_STATS
+		(isRx ? stats.rx : stats.tx).nBytes += nBytes;
+#else
+		(void)isRx; (void)nBytes;
+#endif
+	}
+
+	// records an event of this instance in dmaTrace, e.g. BdRingToHw() / BdRingFromHw() counts (no-op without DMAFEED_TRACE)
+	void trace(dmaTrace::event_e event, bool isRx, u32 arg = 0){dmaTrace::record(event, config.dmaDevId, isRx, arg);}
 
 	// parameters that can be externally configured
 	dmaFeedBaseConfig config;
@@ -93,8 +242,13 @@ protected: // custom derived class would override collectTx(), collectRx(), queu
 	// DMA Rx buffer descriptor ring from XAxiDma_GetRxRing();
 	XAxiDma_BdRing *rxRingPtr = NULL;
 
+	// Rx ring of S2MM channel ix < config.nRxChannels (0: rxRingPtr)
+	XAxiDma_BdRing* getRxRing(unsigned int ix){return XAxiDma_GetRxIndexRing(&iDma, ix);}
+
 	// tx-/rx handlers flag completion here, after all buffers are returned from DMA hardware
-	volatile bool doneFlag = false;
+	// flags shared with the interrupt callbacks are atomics: the store publishes the callback's other writes to run_poll() (a
+	// callback may run on another core, or on the dispatcher thread of the host model)
+	std::atomic<bool> doneFlag{false};
 private:
 	// enables / disables interrupt generation and reception
 	void interruptsOnOff(bool newState);
@@ -112,29 +266,99 @@ private:
 	// whether BD rings are valid and configured on DMA
 	bool BDRingsAreUp = false;
 
+	// run_poll() services the rings (POLL mode, or HYBRID before falling back to interrupts)
+	bool pollingActive = false;
+	// HYBRID: run_poll() calls since last completion
+	unsigned int nIdlePolls = 0;
+	// collects and queues BDs from run_poll(). Returns whether a completion was signaled
+	bool pollService();
+
+	// DEFERRED: IRQ status recorded by the interrupt callbacks since the last bottom half
+	std::atomic<u32> txPendingIrq{0};
+	std::atomic<u32> rxPendingIrq{0};
+	// DEFERRED: interrupt callbacks, connected instead of txCallback / rxCallback
+	static void txDeferredCallback(dmaFeedBase* self);
+	static void rxDeferredCallback(dmaFeedBase* self);
+	// acknowledges the channel's IRQ status and adds it to pending
+	void deferIrq(XAxiDma_BdRing* ringPtr, std::atomic<u32>& pending, channelStats_t& st, bool isRx);
+	// DEFERRED bottom half from run_poll(): takes the pending status, collects and queues. Returns whether a completion was signaled
+	bool deferredService();
+	// common to pollService() and deferredService(): error check, collects both rings, one queue() call
+	bool serviceRings(u32 txIrqStatus, u32 rxIrqStatus, bool deferred);
+
+	// free BDs of the Tx ring, over all Rx rings (0 for an unused channel)
+	int getTxFreeCnt();
+	int getRxFreeCnt();
+
+	// resets the DMA engine, discarding all BDs in hardware
+	void resetDma();
+
+	// coalescing setting of one channel, applied by interruptsDmaOnOff() and adapted by interrupt callbacks
+	typedef struct {
+		u32 n;
+		u32 delay;
+		// previous completion interrupt, 0: none in this transaction
+		XTime tLastIrq;
+	} coalesce_t;
+	coalesce_t txCoalesce;
+	coalesce_t rxCoalesce;
+
+	// adaptive coalescing step after a completion interrupt that freed nBds BDs
+	void adaptCoalesce(XAxiDma_BdRing* ringPtr, coalesce_t& c, u32 irqStatus, int nBds, channelStats_t& st);
+
+	// BDs in hardware in the Tx ring, over all Rx rings (0 for an unused channel)
+	u32 getTxHwCnt();
+	u32 getRxHwCnt();
+
+	// path from interrupt callbacks and run_poll() into the derived class: through the vtable (dmaFeedStatic: direct calls).
+	// Templates below are defined in dmaFeedBaseIsr.h
+	struct virtualDispatch{
+		static constexpr bool hasTx = true;
+		static constexpr bool hasRx = true;
+		static constexpr bool stats = DMAFEED_STATS;
+		static void collectTx(dmaFeedBase* self){self->collectTx();}
+		static void collectRx(dmaFeedBase* self){self->collectRx();}
+		static void queue(dmaFeedBase* self, bool txEvent, bool rxEvent){self->queue(txEvent, rxEvent);}
+	};
+	template<class derived_t, class policy_t> friend class dmaFeedStatic;
+
+	// collectTx() / collectRx() with statistics (time, BDs). Return the number of freed BDs
+	template<class dispatch_t> int serviceTx(bool fromIsr);
+	template<class dispatch_t> int serviceRx(bool fromIsr);
+	// queue() with statistics (time, water marks, dry rings; the latter only afterCollect, rings start empty)
+	template<class dispatch_t> void serviceQueue(bool txEvent, bool rxEvent, bool afterCollect);
+
 	XAxiDma iDma; // DMA hardware block "instance"
 
 	// triggered by DMA Tx interrupt after coalescing
-	static void txInterruptCallback(dmaFeedBase* self);
+	template<class dispatch_t> static void txInterruptCallback(dmaFeedBase* self);
 
 	// triggered by DMA Rx interrupt after coalescing
-	static void rxInterruptCallback(dmaFeedBase* self);
+	template<class dispatch_t> static void rxInterruptCallback(dmaFeedBase* self);
+
+	// interrupt callbacks connected by interruptsIrcOnOff(): virtualDispatch instances, or specialized by dmaFeedStatic
+	Xil_InterruptHandler txCallback;
+	Xil_InterruptHandler rxCallback;
+
+	std::atomic<bool> dmaError{false};
+
+	// see getStats()
+	stats_t stats = {};
+	// runStart() of the current transaction (DMAFEED_STATS)
+	XTime tStart = 0;
 
-	volatile bool dmaError = false;
 	// all memory allocated for buffer descriptors
 	void* bufferDescriptorSpace = NULL;
+	// bufferDescriptorSpace is from dmaBdArena (not dmaFeedBaseConfig::bdSpace)
+	bool bdSpaceIsOwned = false;
 	// memory for tx buffer descriptors (subsection in bufferDescriptorSpace for Tx)
 	void* txBdBufSpace = NULL;
-	// buffer for rx buffer descriptors (subsection in bufferDescriptorSpace for Rx)
+	// buffer for rx buffer descriptors (subsection in bufferDescriptorSpace for Rx, nBytesAllocRxBd per channel)
 	void* rxBdBufSpace = NULL;
 	u32 nBytesAllocTxBd = 0;
 	u32 nBytesAllocRxBd = 0;
-
-#ifdef DMAFEED_HAS_INTC
-	static XIntc iIntc; // interrupt controller "instance"
-#endif
-#ifdef DMAFEED_HAS_SCUGIC
-	static XScuGic iIntc; // interrupt controller "instance"
-#endif
+	// see setRingBdCounts(), 0: all that fit
+	u32 nTxBdRing = 0;
+	u32 nRxBdRing = 0;
 };
 #endif
@@ -0,0 +1,181 @@
+#ifndef DMAFEEDBASEISR_H
+#define DMAFEEDBASEISR_H
+// interrupt callbacks and collect / queue wrappers of dmaFeedBase, as templates over the path into the derived class (dispatch_t):
+// - dmaFeedBase::virtualDispatch: through the vtable, instantiated in dmaFeedBase.cpp
+// - dmaFeedStatic: direct calls, instantiated with the derived class => its collectTx() / collectRx() / queue() inline into
+//   interrupt callbacks specialized for it
+// dispatch_t provides hasTx, hasRx, stats (compile-time flags) and static collectTx(self), collectRx(self), queue(self, txEvent, rxEvent)
+#include "dmaFeedBase.h"
+
+namespace dmaFeedIsr {
+// accumulates time from construction to end of scope into t (no-op if not enabled)
+template<bool enabled> class statsTimer{
+public:
+	statsTimer(u64& t) : t(t){XTime_GetTime(&t0);}
+	~statsTimer(){XTime t1; XTime_GetTime(&t1); t += t1 - t0;}
+private:
+	u64& t;
+	XTime t0;
+};
+template<> class statsTimer<false>{
+public:
+	statsTimer(u64&){}
+};
+
+// power-of-two histogram bin: 0 for 0, k for 2^(k-1) .. 2^k - 1, clipped to the last bin
+inline unsigned int histBin(u64 v){
+	unsigned int k = 0;
+	while (v && (k < DMAFEED_STATS_NBINS - 1)){
+		v >>= 1;
+		++k;
+	}
+	return k;
+}
+
+// BDs in hardware before / after queue(): water marks, and dry ring if queue() found work for an empty ring
+inline void statsQueued(dmaFeedBase::channelStats_t& s, u32 nHwBefore, u32 nHwAfter, bool afterCollect){
+	if (nHwAfter > s.nHwBdsMax)
+		s.nHwBdsMax = nHwAfter;
+	if (!afterCollect || (nHwAfter <= nHwBefore))
+		return; // nothing to queue (e.g. end of data) says nothing about starvation
+	if (nHwBefore < s.nHwBdsMin)
+		s.nHwBdsMin = nHwBefore;
+	if (!nHwBefore)
+		++s.nDry;
+}
+
+// records interrupt callback entry with the IRQ status, and exit with the number of collected BDs at end of scope
+class traceIrq{
+public:
+	traceIrq(u32 devId, bool isRx, u32 irqStatus) : devId(devId), isRx(isRx){dmaTrace::record(dmaTrace::TRACE_IRQ_ENTRY, devId, isRx, irqStatus);}
+	~traceIrq(){dmaTrace::record(dmaTrace::TRACE_IRQ_EXIT, devId, isRx, (u32)nBds);}
+	int nBds = 0;
+private:
+	u32 devId;
+	bool isRx;
+};
+} // namespace dmaFeedIsr
+
+template<class dispatch_t> int dmaFeedBase::serviceTx(bool fromIsr){
+	int nFreeBd = XAxiDma_BdRingGetFreeCnt(txRingPtr);
+	{
+		dmaFeedIsr::statsTimer<dispatch_t::stats> t(stats.collectTime);
+		dispatch_t::collectTx(this); // continue with implementation-specific code to free (and optionally, process) Tx BDs completed by the DMA hardware
+	}
+	int nBds = XAxiDma_BdRingGetFreeCnt(txRingPtr) - nFreeBd;
+	if (dispatch_t::stats){
+		if (fromIsr){
+			stats.tx.nBds += nBds;
+			++stats.tx.bdsPerIrq[dmaFeedIsr::histBin(nBds)];
+		} else
+			stats.tx.nPolledBds += nBds;
+	}
+	return nBds;
+}
+
+template<class dispatch_t> int dmaFeedBase::serviceRx(bool fromIsr){
+	int nFreeBd = getRxFreeCnt();
+	{
+		dmaFeedIsr::statsTimer<dispatch_t::stats> t(stats.collectTime);
+		dispatch_t::collectRx(this); // continue with implementation-specific code to free (and optionally, process) Rx BDs completed by the DMA hardware
+	}
+	int nBds = getRxFreeCnt() - nFreeBd;
+	if (dispatch_t::stats){
+		if (fromIsr){
+			stats.rx.nBds += nBds;
+			++stats.rx.bdsPerIrq[dmaFeedIsr::histBin(nBds)];
+		} else
+			stats.rx.nPolledBds += nBds;
+	}
+	return nBds;
+}
+
+template<class dispatch_t> void dmaFeedBase::serviceQueue(bool txEvent, bool rxEvent, bool afterCollect){
+	u32 nTxHw = 0;
+	u32 nRxHw = 0;
+	if (dispatch_t::stats){
+		nTxHw = getTxHwCnt();
+		nRxHw = getRxHwCnt();
+	}
+	{
+		dmaFeedIsr::statsTimer<dispatch_t::stats> t(stats.queueTime);
+		dispatch_t::queue(this, txEvent, rxEvent);
+	}
+	if (dispatch_t::stats){
+		dmaFeedIsr::statsQueued(stats.tx, nTxHw, getTxHwCnt(), afterCollect);
+		dmaFeedIsr::statsQueued(stats.rx, nRxHw, getRxHwCnt(), afterCollect);
+	}
+}
+
+template<class dispatch_t> void dmaFeedBase::txInterruptCallback(dmaFeedBase* self){
+	dmaFeedIsr::statsTimer<dispatch_t::stats> t(self->stats.tx.isrTime);
+	if (dispatch_t::stats)
+		++self->stats.tx.nInterrupts;
+
+	// === get and acknowledge IRQ status ===
+	u32 irqStatus = XAxiDma_BdRingGetIrq(self->txRingPtr);
+	XAxiDma_BdRingAckIrq(self->txRingPtr, irqStatus);
+	dmaFeedIsr::traceIrq tr(self->config.dmaDevId, /*isRx*/false, irqStatus);
+
+	if (!(irqStatus & XAXIDMA_IRQ_ALL_MASK))
+		return; // nothing to do (shortcut)
+
+	if (self->doneFlag)
+		return; // possible delay interrupt after user code has flagged completion, suppress callbacks
+
+	if ((irqStatus & XAXIDMA_IRQ_ERROR_MASK)){
+		self->trace(dmaTrace::TRACE_ERROR, /*isRx*/false, irqStatus);
+		self->dmaError = true;
+	}
+
+	if (self->dmaError)
+		return; // no user code callbacks in error state, pending reset
+
+	if (!dispatch_t::hasTx || !(irqStatus & (XAXIDMA_IRQ_DELAY_MASK | XAXIDMA_IRQ_IOC_MASK)))
+		return;
+
+	int nBds = tr.nBds = self->serviceTx<dispatch_t>(/*fromIsr*/true);
+	if (self->doneFlag)
+		return; // completed by collect: nothing left to queue, and the application may already set up the next transaction
+	if (self->config.coalesceAdaptive)
+		self->adaptCoalesce(self->txRingPtr, self->txCoalesce, irqStatus, nBds, self->stats.tx);
+	// HYBRID: status latched during polling may signal BDs that run_poll() already collected => ring can still be full
+	self->serviceQueue<dispatch_t>(/*txEvent*/XAxiDma_BdRingGetFreeCnt(self->txRingPtr) > 0, /*rxEvent*/false, /*afterCollect*/true);
+}
+
+template<class dispatch_t> void dmaFeedBase::rxInterruptCallback(dmaFeedBase* self){
+	dmaFeedIsr::statsTimer<dispatch_t::stats> t(self->stats.rx.isrTime);
+	if (dispatch_t::stats)
+		++self->stats.rx.nInterrupts;
+
+	// === get and acknowledge IRQ status ===
+	u32 irqStatus = XAxiDma_BdRingGetIrq(self->rxRingPtr);
+	XAxiDma_BdRingAckIrq(self->rxRingPtr, irqStatus);
+	dmaFeedIsr::traceIrq tr(self->config.dmaDevId, /*isRx*/true, irqStatus);
+
+	if (!(irqStatus & XAXIDMA_IRQ_ALL_MASK))
+		return; // nothing to do (shortcut)
+
+	if (self->doneFlag)
+		return; // possible delay interrupt after user code has flagged completion, suppress callbacks
+
+	if ((irqStatus & XAXIDMA_IRQ_ERROR_MASK)){
+		self->trace(dmaTrace::TRACE_ERROR, /*isRx*/true, irqStatus);
+		self->dmaError = true;
+	}
+
+	if (self->dmaError)
+		return; // no callbacks in error state, pending reset
+
+	if (!dispatch_t::hasRx || !(irqStatus & (XAXIDMA_IRQ_DELAY_MASK | XAXIDMA_IRQ_IOC_MASK)))
+		return;
+
+	int nBds = tr.nBds = self->serviceRx<dispatch_t>(/*fromIsr*/true);
+	if (self->doneFlag)
+		return; // completed by collect: nothing left to queue, and the application may already set up the next transaction
+	if (self->config.coalesceAdaptive)
+		self->adaptCoalesce(self->rxRingPtr, self->rxCoalesce, irqStatus, nBds, self->stats.rx);
+	// HYBRID: status latched during polling may signal BDs that run_poll() already collected => ring can still be full
+	self->serviceQueue<dispatch_t>(/*txEvent*/false, /*rxEvent*/self->getRxFreeCnt() > 0, /*afterCollect*/true);
+}
+#endif
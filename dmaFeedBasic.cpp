@@ -1,22 +1,64 @@
 #include "dmaFeedBasic.h"
-dmaFeedBasic::dmaFeedBasic(const dmaFeedBasicConfig& config) : dmaFeedBase(config), maxPacketSize(config.maxPacketSize){
-	// note: config fields added by this custom class (currently only one) are
+
+namespace {
+// merges flushes of consecutive, adjacent chunks into one Xil_DCacheFlushRange() call (none if not enabled: coherent buffers)
+template<bool enabled> class flushSpan{
+public:
+	void add(char* addr, u32 nBytes){
+		if (addr != end)
+			flush();
+		if (!start)
+			start = addr;
+		end = addr + nBytes;
+	}
+	void flush(){
+		if (enabled && start)
+			Xil_DCacheFlushRange((INTPTR)start, end - start);
+		start = end = NULL;
+	}
+private:
+	char* start = NULL;
+	char* end = NULL;
+};
+} // namespace
+
+dmaFeedBasic::dmaFeedBasic(const dmaFeedBasicConfig& config) : dmaFeedStatic(config, config.inlineIsr), rxCompleteOnEof(config.rxCompleteOnEof),
+	resumeMaxRetries(config.resumeMaxRetries), resumeLinked(config.resumeLinked), maxPacketSize(config.maxPacketSize), fastBdFill(config.fastBdFill), replay(config.replay){
+	// note: dmaFeedBase keeps a copy of the dmaFeedBaseConfig part only. The fields added by dmaFeedBasicConfig are copied into
+	// members above
+	assert((config.nRxChannels == 1) && "multichannel Rx needs dmaFeedStream");
+	assert(!(config.replay && config.rxCompleteOnEof) && "replay needs fixed-length Rx");
+	assert(!(config.replay && !(config.useTx && config.useRx)) && "replay needs both channels");
+	assert(!(config.resumeMaxRetries && config.rxCompleteOnEof) && "resume needs fixed-length Rx");
 }
 
-unsigned int dmaFeedBasic::bytesToBufs(unsigned int nBytes, unsigned int nBufAvailable) const {
-	u32 nBuf = nBytes / maxPacketSize;
-	u32 nBytesRem = nBytes - nBuf * maxPacketSize;
-	if (nBytesRem > 0)
-		++nBuf;
+unsigned int dmaFeedBasic::segmentsToBufs(cursor_t c, unsigned int nBufAvailable) const {
+	unsigned int nBuf = 0;
+	for (; (c.seg != c.segEnd) && (nBuf < nBufAvailable); ++c.seg, c.offset = 0)
+		nBuf += (c.seg->nBytes - c.offset + maxPacketSize - 1) / maxPacketSize;
 	return (nBuf > nBufAvailable) ? nBufAvailable : nBuf;
 }
 
+void dmaFeedBasic::nextChunk(cursor_t& c, char*& addr, u32& nBytes) const {
+	while (c.seg->nBytes == c.offset){ // skip empty segments
+		++c.seg;
+		c.offset = 0;
+		assert(c.seg != c.segEnd);
+	}
+	u32 nBytesRem = c.seg->nBytes - c.offset;
+	addr = c.seg->addr + c.offset;
+	nBytes = maxPacketSize < nBytesRem ? maxPacketSize : nBytesRem;
+	c.offset += nBytes;
+}
+
 void dmaFeedBasic::collectTx()/*override*/{
 	// === get completed BDs ===
 	// note: this will be empty on startup
 	XAxiDma_Bd *firstBdPtr; // first buffer descriptor in returned set
 	int nBd = XAxiDma_BdRingFromHw(txRingPtr, /*no limit to the number of returned BDs*/XAXIDMA_ALL_BDS, &firstBdPtr);
 	XAxiDma_Bd *itBdPtr = firstBdPtr;
+	if (nBd)
+		trace(dmaTrace::TRACE_FROM_HW, /*isRx*/false, nBd);
 	//xil_printf("tx int callback status: %08x with %i BDs\r\n", irqStatus, nBd);
 
 	// === count transmitted bytes ===
@@ -30,6 +72,8 @@ void dmaFeedBasic::collectTx()/*override*/{
 		itBdPtr = (XAxiDma_Bd *)XAxiDma_BdRingNext(txRingPtr, itBdPtr);
 	}
 
+	statsBytes(/*isRx*/false, numNewBytesTransmitted);
+
 	// === return completed BDs to pool ===
 	int s = XAxiDma_BdRingFree(txRingPtr, nBd, firstBdPtr); assert(s == XST_SUCCESS && "XAxiDma_BdRingFree(Tx) failed");
 
@@ -40,7 +84,7 @@ void dmaFeedBasic::collectTx()/*override*/{
 	if (!nTxBytesRemainingToComplete){
 		txDone = true;
 		if (txDone && rxDone)
-			done();
+			done(/*rxLeftArmed*/rxCompleteOnEof);
 	}
 }
 
@@ -50,22 +94,53 @@ void dmaFeedBasic::collectRx()/*override*/{
 	XAxiDma_Bd *firstBdPtr; // first buffer descriptor in returned set
 	int nBd = XAxiDma_BdRingFromHw(rxRingPtr, /*no limit to the number of returned BDs*/XAXIDMA_ALL_BDS, &firstBdPtr);
 	XAxiDma_Bd *itBdPtr = firstBdPtr;
+	if (nBd)
+		trace(dmaTrace::TRACE_FROM_HW, /*isRx*/true, nBd);
 
 	// === count received bytes ===
 	unsigned int numNewBytesReceived = 0;
+	bool eof = false;
 	int bdCount = nBd;
 	while (bdCount--){
 		u32 bdStatus = XAxiDma_BdGetSts(itBdPtr);
 		assert(!(bdStatus & XAXIDMA_BD_STS_ALL_ERR_MASK));
 	    assert(bdStatus & XAXIDMA_BD_STS_COMPLETE_MASK);
-	    numNewBytesReceived += XAxiDma_BdGetLength(itBdPtr, rxRingPtr->MaxTransferLen);
+
+		// lines may have been speculatively fetched while the DMA wrote the chunk
+		u32 nActual = XAxiDma_BdGetActualLength(itBdPtr, rxRingPtr->MaxTransferLen);
+		cacheInvalidate((void*)XAxiDma_BdGetBufAddr(itBdPtr), nActual);
+		statsBytes(/*isRx*/true, nActual);
+
+		if (rxCompleteOnEof){
+			// BDs after the first RXEOF belong to the next packet => dropped
+			if (!eof && !rxDone){
+				nRxBytesReceived += nActual;
+				nRxBytesConsumed += XAxiDma_BdGetLength(itBdPtr, rxRingPtr->MaxTransferLen);
+			}
+			eof |= (bdStatus & XAXIDMA_BD_STS_RXEOF_MASK) != 0;
+		} else
+			numNewBytesReceived += XAxiDma_BdGetLength(itBdPtr, rxRingPtr->MaxTransferLen);
 		itBdPtr = (XAxiDma_Bd *)XAxiDma_BdRingNext(rxRingPtr, itBdPtr);
 	}
 
 	// === return completed BDs to pool ===
 	int s = XAxiDma_BdRingFree(rxRingPtr, nBd, firstBdPtr); assert(s == XST_SUCCESS && "XAxiDma_BdRingFree(Rx) failed");
 
+	if (rxCompleteOnEof){
+		// === detect end of packet ===
+		if (eof && !rxDone){
+			// stop queueing. BDs still in hardware are reclaimed by the next runStart()
+			rxCursor.seg = rxCursor.segEnd;
+			nRxBytesRemainingToQueue = 0;
+			rxDone = true;
+			if (txDone && rxDone)
+				done(/*rxLeftArmed*/rxCompleteOnEof);
+		}
+		return;
+	}
+
 	// === detect end of reception ===
+	nRxBytesReceived += numNewBytesReceived;
 	assert(numNewBytesReceived <= nRxBytesRemainingToComplete);
 	nRxBytesRemainingToComplete -= numNewBytesReceived;
 
@@ -77,6 +152,9 @@ void dmaFeedBasic::collectRx()/*override*/{
 }
 
 void dmaFeedBasic::queue(bool txEvent, bool rxEvent)/*override*/{
+	// runReplay(): the Rx chain goes to hardware ahead of the Tx chain
+	if (rxEvent && rxReplayPending)
+		queueRx();
 	if (txEvent)
 		queueTx();
 	if (rxEvent)
@@ -84,10 +162,16 @@ void dmaFeedBasic::queue(bool txEvent, bool rxEvent)/*override*/{
 }
 
 void dmaFeedBasic::queueTx(){
+	if (txReplayPending){
+		txReplayPending = false;
+		replayToHw(txRingPtr, /*isRx*/false);
+		return;
+	}
+
 	// number of available (idle) buffers
 	int nFreeBd = XAxiDma_BdRingGetFreeCnt(txRingPtr); assert(nFreeBd && "queueTx() should never encounter zero idle buffers");
 	// number of buffers to queue
-	unsigned int nBufsToQueue = bytesToBufs(nTxBytesRemainingToQueue, /*limit to*/nFreeBd);
+	unsigned int nBufsToQueue = segmentsToBufs(txCursor, /*limit to*/nFreeBd);
 	//xil_printf("queueTx got %i free Bds need %i\r\n", nFreeBd, nBufsToQueue);
 
 	int s;
@@ -98,15 +182,14 @@ void dmaFeedBasic::queueTx(){
 
 		unsigned int count = nBufsToQueue;
 		bool isFirstBd = true;
+		flushSpan<policy::cacheMaintenance> flush; // fastBdFill
 		while (count--){
 			bool isLastBd = !count;
-			int thisBufNBytes = maxPacketSize < nTxBytesRemainingToQueue ? maxPacketSize : nTxBytesRemainingToQueue;
+			char* txPtr;
+			u32 thisBufNBytes;
+			nextChunk(txCursor, txPtr, thisBufNBytes);
 			assert (thisBufNBytes); // nBufsToQueue calculation makes certain this never becomes 0
 
-			// === assign next chunk of Tx data to Bd ===
-			s = XAxiDma_BdSetBufAddr(itBdPtr, (UINTPTR)txPtr); assert(s == XST_SUCCESS && "DMA feedTx: BdSetBufAddr() failed");
-			s = XAxiDma_BdSetLength(itBdPtr, thisBufNBytes, txRingPtr->MaxTransferLen); assert(s == XST_SUCCESS && "DMA feedTx: BdSetLength() failed");
-
 			// === flag first and last BD ===
 			u32 crBits = 0;
 			if (isFirstBd){
@@ -116,28 +199,52 @@ void dmaFeedBasic::queueTx(){
 			if (isLastBd){
 				crBits |= XAXIDMA_BD_CTRL_TXEOF_MASK;
 			}
-			XAxiDma_BdSetCtrl(itBdPtr, crBits);
 
-			// === set arbitrary ID ===
-			XAxiDma_BdSetId(itBdPtr, txPtr);
+			if (fastBdFill){
+				// === stamp BD (address, length, flags, ID) ===
+				bdTemplate.stamp(itBdPtr, (UINTPTR)txPtr, thisBufNBytes, crBits, txRingPtr->MaxTransferLen, (UINTPTR)txPtr);
+				// the DMA sees none of these chunks before BdRingToHw() => one flush per contiguous run
+				flush.add(txPtr, thisBufNBytes);
+			} else {
+				// === assign next chunk of Tx data to Bd ===
+				s = XAxiDma_BdSetBufAddr(itBdPtr, (UINTPTR)txPtr); assert(s == XST_SUCCESS && "DMA feedTx: BdSetBufAddr() failed");
+				s = XAxiDma_BdSetLength(itBdPtr, thisBufNBytes, txRingPtr->MaxTransferLen); assert(s == XST_SUCCESS && "DMA feedTx: BdSetLength() failed");
+
+				// DMA doesn't go through cache => must flush, per chunk: overlaps with the DMA working on earlier BDs
+				cacheFlush(txPtr, thisBufNBytes);
+
+				XAxiDma_BdSetCtrl(itBdPtr, crBits);
+
+				// === set arbitrary ID ===
+				XAxiDma_BdSetId(itBdPtr, txPtr);
+			}
 
 			// === next ... ===
 			itBdPtr = (XAxiDma_Bd*)XAxiDma_BdRingNext(txRingPtr, itBdPtr); assert(itBdPtr);
 
-			txPtr += thisBufNBytes;
 			nTxBytesRemainingToQueue -= thisBufNBytes;
 		} // for all bufs to queue
+		flush.flush();
 
 		// === submit to hardware ===
 		s = XAxiDma_BdRingToHw(txRingPtr, nBufsToQueue, firstBdPtr); assert (s == XST_SUCCESS && "DMA queueTx: BdRingToHw() failed");
+		trace(dmaTrace::TRACE_TO_HW, /*isRx*/false, nBufsToQueue);
 	} // if bufs to queue
 }
 
 void dmaFeedBasic::queueRx(){
+	if (rxReplayPending){
+		rxReplayPending = false;
+		replayToHw(rxRingPtr, /*isRx*/true);
+		return;
+	}
+	if (rxCursor.seg == rxCursor.segEnd)
+		return; // nothing to queue (runReplay(): no free BD either)
+
 	int nFreeBd = XAxiDma_BdRingGetFreeCnt(rxRingPtr); assert(nFreeBd && "queueRx() should never encounter zero idle buffers");
 
 	// number of buffers to queue
-	unsigned int nBufsToQueue = bytesToBufs(nRxBytesRemainingToQueue, /*limit to*/nFreeBd);
+	unsigned int nBufsToQueue = segmentsToBufs(rxCursor, /*limit to*/nFreeBd);
 	//xil_printf("queueRx got %i free Bds need %i\r\n", nFreeBd, nBufsToQueue);
 
 	int s;
@@ -146,36 +253,288 @@ void dmaFeedBasic::queueRx(){
 		s = XAxiDma_BdRingAlloc(rxRingPtr, nBufsToQueue, &firstBdPtr); assert (s == XST_SUCCESS && "DMA queueRx: BdRingAlloc() failed");
 		XAxiDma_Bd* itBdPtr = firstBdPtr;
 
+		flushSpan<policy::cacheMaintenance> flush; // fastBdFill
 		for (unsigned int ix = 0; ix < nBufsToQueue; ++ix){
-			s = XAxiDma_BdSetBufAddr(itBdPtr, (UINTPTR)rxPtr); assert (s == XST_SUCCESS && "DMA queueRx: BdSetBufAddr() failed");
-			int n = maxPacketSize < nRxBytesRemainingToQueue ? maxPacketSize : nRxBytesRemainingToQueue;
-			s = XAxiDma_BdSetLength(itBdPtr, n, rxRingPtr->MaxTransferLen); assert (s == XST_SUCCESS && "DMA queueRx: BdSetLength() failed");
+			char* rxPtr;
+			u32 n;
+			nextChunk(rxCursor, rxPtr, n);
+			if (fastBdFill){
+				bdTemplate.stamp(itBdPtr, (UINTPTR)rxPtr, n, /*ctrlBits*/0, rxRingPtr->MaxTransferLen, (UINTPTR)rxPtr);
+				flush.add(rxPtr, n); // no dirty lines may be evicted over DMA data
+			} else {
+				s = XAxiDma_BdSetBufAddr(itBdPtr, (UINTPTR)rxPtr); assert (s == XST_SUCCESS && "DMA queueRx: BdSetBufAddr() failed");
+				s = XAxiDma_BdSetLength(itBdPtr, n, rxRingPtr->MaxTransferLen); assert (s == XST_SUCCESS && "DMA queueRx: BdSetLength() failed");
 
-			XAxiDma_BdSetCtrl(itBdPtr, 0); // unnecessary (HW will set)
-			XAxiDma_BdSetId(itBdPtr, rxPtr); // assign arbitrary ID
+				// no dirty lines may be evicted over DMA data
+				cacheFlush(rxPtr, n);
+
+				XAxiDma_BdSetCtrl(itBdPtr, 0); // unnecessary (HW will set)
+				XAxiDma_BdSetId(itBdPtr, rxPtr); // assign arbitrary ID
+			}
 
 			// === next ... ===
-			rxPtr += n;
 			nRxBytesRemainingToQueue -= n;
 			itBdPtr = (XAxiDma_Bd*)XAxiDma_BdRingNext(rxRingPtr, itBdPtr); assert(itBdPtr);
 		}
+		flush.flush();
 
 		s = XAxiDma_BdRingToHw(rxRingPtr, nBufsToQueue, firstBdPtr); assert (s == XST_SUCCESS && "DMA queueRx: BdRingToHw() failed");
+		trace(dmaTrace::TRACE_TO_HW, /*isRx*/true, nBufsToQueue);
 	} // if bufs to queue
 }
 
 void dmaFeedBasic::runStart(char* txBuf, u32 numTxBytes, char* rxBuf, u32 numRxBytes){
-	assert(((uintptr_t)txBuf & 3) == 0); // check alignment
-	assert(((uintptr_t)rxBuf & 3) == 0); // check alignment
-	txPtr = txBuf;
-	rxPtr = rxBuf;
+	txSingle = {txBuf, numTxBytes};
+	rxSingle = {rxBuf, numRxBytes};
+	runStart(&txSingle, 1, &rxSingle, 1);
+}
+
+void dmaFeedBasic::runStart(const segment_t* txSegs, unsigned int nTxSegs, const segment_t* rxSegs, unsigned int nRxSegs){
+	u32 numTxBytes = 0;
+	for (unsigned int ix = 0; ix < nTxSegs; ++ix){
+		assert(((uintptr_t)txSegs[ix].addr & 3) == 0); // check alignment
+		numTxBytes += txSegs[ix].nBytes;
+	}
+	u32 numRxBytes = 0;
+	for (unsigned int ix = 0; ix < nRxSegs; ++ix){
+		assert(((uintptr_t)rxSegs[ix].addr & 3) == 0); // check alignment
+		numRxBytes += rxSegs[ix].nBytes;
+	}
+	assert((config.useTx || !numTxBytes) && (config.useRx || !numRxBytes) && "data for an unused channel");
+	assert((numTxBytes || numRxBytes) && "empty transaction");
+	// === Rx BDs left armed by a transaction that completed on RXEOF ===
+	// armed BDs would receive the start of the next packet. Adopted as the first BDs of this transaction if they match its Rx
+	// range, otherwise retired with S2MM halted. Reset only if data arrived in between
+	cursor_t rxStart = {rxSegs, rxSegs + nRxSegs, 0};
+	cursor_t rxAfterAdopted = rxStart;
+	u32 nRxBytesAdopted = 0;
+	if (rxCompleteOnEof && rxRingPtr->HwCnt){
+		// from the check on, a leftover BD that completes must interrupt this transaction: masked until dmaFeedBase::runStart() is done
+		Xil_ExceptionDisable();
+		if (!adoptRxBds(rxAfterAdopted, nRxBytesAdopted) && !retireRxBds()){
+			Xil_ExceptionEnable();
+			abort();
+		}
+	}
+
+	txCursor = {txSegs, txSegs + nTxSegs, 0};
+	rxCursor = rxStart;
+	if (replay){
+		// === record: rings of exactly this transaction's BDs, programmed by queue() as usual ===
+		unsigned int nTxBds = segmentsToBufs(txCursor, /*no limit*/~0u);
+		unsigned int nRxBds = segmentsToBufs(rxCursor, /*no limit*/~0u);
+		assert(nTxBds && nRxBds && "replay needs Tx and Rx data");
+		setRingBdCounts(nTxBds, nRxBds);
+		txRecorded = txCursor;
+		rxRecorded = rxCursor;
+		nTxBytesRecorded = numTxBytes;
+		nRxBytesRecorded = numRxBytes;
+		replayRecorded = true;
+	}
+	txReplayPending = false;
+	rxReplayPending = false;
 	nTxBytesRemainingToQueue = numTxBytes;
-	nRxBytesRemainingToQueue = numRxBytes;
+	nRxBytesRemainingToQueue = numRxBytes - nRxBytesAdopted;
 	nTxBytesRemainingToComplete = numTxBytes;
 	nRxBytesRemainingToComplete = numRxBytes;
+	nRxBytesReceived = 0;
+	nRxBytesConsumed = 0;
+	// a channel without data (unused) is done from the start
+	txDone = !numTxBytes;
+	rxDone = !numRxBytes;
+	txBegin = txCursor;
+	rxBegin = rxCursor;
+	rxCursor = rxAfterAdopted;
+	nTxBytesTotal = numTxBytes;
+	nRxBytesTotal = numRxBytes;
+	nResumes = 0;
+	nTxBytesRetransmitted = 0;
 
-	// DMA doesn't go through cache => must flush
-	Xil_DCacheFlushRange((INTPTR)txBuf, numTxBytes);
-	Xil_DCacheFlushRange((INTPTR)rxBuf, numRxBytes);
 	dmaFeedBase::runStart();
 }
+
+void dmaFeedBasic::runReplay(){
+	assert(replay && "runReplay() needs dmaFeedBasicConfig::replay");
+	assert(txRecorded.seg && "runReplay() before runStart()");
+	if (!replayRecorded || !bdRingsAreUp()){
+		// nothing recorded yet, or rings rebuilt after an error / abort(): record again
+		runStart(txRecorded.seg, txRecorded.segEnd - txRecorded.seg, rxRecorded.seg, rxRecorded.segEnd - rxRecorded.seg);
+		return;
+	}
+
+	// the application may have written Tx data and Rx buffers since the last run. Rx BDs are armed after this (by queue(), ahead
+	// of Tx): until then, the application owns the Rx buffers
+	flushSegments(txRecorded);
+	flushSegments(rxRecorded);
+
+	// nothing left to queue BD by BD
+	txCursor = {txRecorded.segEnd, txRecorded.segEnd, 0};
+	rxCursor = {rxRecorded.segEnd, rxRecorded.segEnd, 0};
+	nTxBytesRemainingToQueue = 0;
+	nRxBytesRemainingToQueue = 0;
+	nTxBytesRemainingToComplete = nTxBytesRecorded;
+	nRxBytesRemainingToComplete = nRxBytesRecorded;
+	nRxBytesReceived = 0;
+	nRxBytesConsumed = 0;
+	txDone = false;
+	rxDone = false;
+	txReplayPending = true;
+	rxReplayPending = true;
+	txBegin = txRecorded;
+	rxBegin = rxRecorded;
+	nTxBytesTotal = nTxBytesRecorded;
+	nRxBytesTotal = nRxBytesRecorded;
+	nResumes = 0;
+	nTxBytesRetransmitted = 0;
+
+	dmaFeedBase::runStart();
+}
+
+void dmaFeedBasic::replayToHw(XAxiDma_BdRing* ringPtr, bool isRx){
+	// the ring holds exactly one transaction and is empty => BdRingAlloc() returns the recorded BDs, in order
+	int nBd = ringPtr->AllCnt;
+	assert((XAxiDma_BdRingGetFreeCnt(ringPtr) == nBd) && "replay: BDs of the previous run not collected");
+	XAxiDma_Bd* firstBdPtr;
+	int s = XAxiDma_BdRingAlloc(ringPtr, nBd, &firstBdPtr); assert (s == XST_SUCCESS && "DMA replay: BdRingAlloc() failed");
+	s = XAxiDma_BdRingToHw(ringPtr, nBd, firstBdPtr); assert (s == XST_SUCCESS && "DMA replay: BdRingToHw() failed"); (void)s;
+	trace(dmaTrace::TRACE_TO_HW, isRx, nBd);
+}
+
+void dmaFeedBasic::flushSegments(cursor_t c){
+	for (; c.seg != c.segEnd; ++c.seg)
+		cacheFlush(c.seg->addr, c.seg->nBytes);
+}
+
+bool dmaFeedBasic::onError()/*override*/{
+	if (rxCompleteOnEof)
+		return false;
+
+	// === confirmed offsets: BDs the hardware finished before the error ===
+	// error halts both channels' callbacks (the other channel may still have run on) => collect what the ISR did not
+	u32 nTx = config.useTx ? salvageCompleted(txRingPtr, /*isRx*/false) : 0;
+	u32 nRx = config.useRx ? salvageCompleted(rxRingPtr, /*isRx*/true) : 0;
+	assert((nTx <= nTxBytesRemainingToComplete) && (nRx <= nRxBytesRemainingToComplete));
+	nTxBytesRemainingToComplete -= nTx;
+	nRxBytesRemainingToComplete -= nRx;
+	nRxBytesReceived += nRx;
+
+	if (nResumes >= resumeMaxRetries)
+		return false;
+	++nResumes;
+	resume();
+	return true;
+}
+
+u32 dmaFeedBasic::salvageCompleted(XAxiDma_BdRing* ringPtr, bool isRx){
+	u32 nBytes = 0;
+	XAxiDma_Bd* bdPtr = ringPtr->HwHead;
+	for (int ix = 0; ix < ringPtr->HwCnt; ++ix){
+		u32 bdStatus = XAxiDma_BdGetSts(bdPtr);
+		if (!(bdStatus & XAXIDMA_BD_STS_COMPLETE_MASK) || (bdStatus & XAXIDMA_BD_STS_ALL_ERR_MASK))
+			break; // in order: nothing after the first incomplete / failed BD counts
+		if (isRx)
+			cacheInvalidate((void*)XAxiDma_BdGetBufAddr(bdPtr), XAxiDma_BdGetActualLength(bdPtr, ringPtr->MaxTransferLen));
+		u32 n = XAxiDma_BdGetLength(bdPtr, ringPtr->MaxTransferLen);
+		statsBytes(isRx, n);
+		nBytes += n;
+		bdPtr = (XAxiDma_Bd*)XAxiDma_BdRingNext(ringPtr, bdPtr);
+	}
+	return nBytes;
+}
+
+void dmaFeedBasic::resume(){
+	u32 txOffset = getTxBytesConfirmed();
+	u32 rxOffset = getRxBytesConfirmed();
+	if (resumeLinked && config.useTx && config.useRx)
+		txOffset = rxOffset = (txOffset < rxOffset) ? txOffset : rxOffset; // data between was in flight in the stream, lost by the reset
+	// everything queued beyond the resume offset is queued again, whether the hardware had sent it or not
+	nTxBytesRetransmitted += getTxBytesQueued() - txOffset;
+
+	// the rebuilt rings no longer hold the recorded transaction
+	replayRecorded = false;
+	txReplayPending = false;
+	rxReplayPending = false;
+
+	txCursor = cursorAt(txBegin, txOffset);
+	rxCursor = cursorAt(rxBegin, rxOffset);
+	nTxBytesRemainingToQueue = nTxBytesRemainingToComplete = nTxBytesTotal - txOffset;
+	nRxBytesRemainingToQueue = nRxBytesRemainingToComplete = nRxBytesTotal - rxOffset;
+	nRxBytesReceived = rxOffset;
+	txDone = !nTxBytesRemainingToComplete;
+	rxDone = !nRxBytesRemainingToComplete;
+	// before runStart(): from there on, the callbacks may complete the resumed transaction
+	bool complete = txDone && rxDone;
+
+	dmaFeedBase::runStart(); // rebuilds the rings
+	if (complete)
+		done(); // independent channels: both had completed, only the error was left to report
+}
+
+bool dmaFeedBasic::adoptRxBds(cursor_t& c, u32& nBytes){
+	if (!bdRingsAreUp())
+		return false; // reset since (error, abort()): ring bookkeeping is stale
+	// completion is in order => the first BD tells. Data arrived between the transactions, its interrupt was suppressed (doneFlag)
+	XAxiDma_Bd* bdPtr = rxRingPtr->HwHead;
+	if (XAxiDma_BdGetSts(bdPtr) & XAXIDMA_BD_STS_COMPLETE_MASK)
+		return false;
+
+	// the BDs queueRx() would program for this range, compared with the armed ones
+	cursor_t it = c;
+	u32 n = 0;
+	for (int ix = 0; ix < rxRingPtr->HwCnt; ++ix){
+		if (!segmentsToBufs(it, /*limit to*/1))
+			return false; // range ends within the armed BDs
+		char* rxPtr;
+		u32 nChunk;
+		nextChunk(it, rxPtr, nChunk);
+		if ((XAxiDma_BdGetBufAddr(bdPtr) != (UINTPTR)rxPtr) || (XAxiDma_BdGetLength(bdPtr, rxRingPtr->MaxTransferLen) != nChunk))
+			return false;
+		n += nChunk;
+		bdPtr = (XAxiDma_Bd*)XAxiDma_BdRingNext(rxRingPtr, bdPtr);
+	}
+	c = it;
+	nBytes = n;
+	return true;
+}
+
+bool dmaFeedBasic::retireRxBds(){
+	if (!bdRingsAreUp())
+		return false; // reset since (error, abort()): ring bookkeeping is stale
+
+	// === halt S2MM (DMACR.RS). MM2S keeps running ===
+	UINTPTR chanBase = rxRingPtr->ChanBase;
+	XAxiDma_WriteReg(chanBase, XAXIDMA_CR_OFFSET, XAxiDma_ReadReg(chanBase, XAXIDMA_CR_OFFSET) & ~XAXIDMA_CR_RUNSTOP_MASK);
+	rxRingPtr->RunState = AXIDMA_CHANNEL_HALTED;
+	bool halted = false;
+	for (unsigned int ix = 0; !halted && (ix < 10000); ++ix)
+		halted = XAxiDma_ReadReg(chanBase, XAXIDMA_SR_OFFSET) & XAXIDMA_HALTED_MASK;
+	// completion is in order => the first BD tells whether data arrived. A packet may then be partly received
+	if (!halted || (XAxiDma_BdGetSts(rxRingPtr->HwHead) & XAXIDMA_BD_STS_COMPLETE_MASK))
+		return false;
+
+	// === retire the armed BDs: hardware -> post-processing -> free, as BdRingFromHw() would return them ===
+	int nBd = rxRingPtr->HwCnt;
+	assert(!rxRingPtr->PostCnt && !rxRingPtr->PreCnt); // all collected, nothing allocated
+	XAxiDma_Bd* firstBdPtr = rxRingPtr->HwHead;
+	rxRingPtr->HwHead = (XAxiDma_Bd*)XAxiDma_BdRingNext(rxRingPtr, rxRingPtr->HwTail);
+	rxRingPtr->HwCnt = 0;
+	rxRingPtr->PostCnt = nBd;
+	int s = XAxiDma_BdRingFree(rxRingPtr, nBd, firstBdPtr); assert(s == XST_SUCCESS && "XAxiDma_BdRingFree(Rx) failed"); (void)s;
+
+	// === new chain starts at the next BD queueRx() allocates ===
+	// dmaFeedBase::runStart() restarts the halted ring: BdRingStart() writes CURDESC from BdaRestart, unless that BD still shows
+	// an old completion
+	XAxiDma_BdWrite(rxRingPtr->HwHead, XAXIDMA_BD_STS_OFFSET, 0);
+	rxRingPtr->BdaRestart = rxRingPtr->HwHead; // rings are created with physical == virtual addresses
+	return true;
+}
+
+dmaFeedBasic::cursor_t dmaFeedBasic::cursorAt(cursor_t c, u32 offset){
+	while ((c.seg != c.segEnd) && (offset >= c.seg->nBytes - c.offset)){
+		offset -= c.seg->nBytes - c.offset;
+		++c.seg;
+		c.offset = 0;
+	}
+	c.offset += offset;
+	return c;
+}
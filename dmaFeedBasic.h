@@ -1,6 +1,7 @@
 #ifndef DMAFEEDBASIC_H
 #define DMAFEEDBASIC_H
-#include "dmaFeedBase.h"
+#include "dmaFeedStatic.h"
+#include "dmaBdTemplate.h"
 
 // all fields may be optionally configured before passing to dmaFeed constructor
 class dmaFeedBasicConfig: public dmaFeedBaseConfig{
@@ -8,17 +9,87 @@ public:
 	dmaFeedBasicConfig(unsigned int dmaDevId, unsigned int txIntrId, unsigned int rxIntrId) : dmaFeedBaseConfig(dmaDevId, txIntrId, rxIntrId){
 	}
 	u32 maxPacketSize = 1 << 13; // up to configured width of DMA length register e.g. XPAR_AXI_DMA_0_SG_LENGTH_WIDTH
+	// Rx completes on the first end of packet (RXEOF) instead of after exactly numRxBytes, which becomes the capacity
+	// - see getRxBytesReceived(). Data of later packets in BDs returned with the first one is dropped.
+	// - the packet must fit into the capacity, otherwise reception does not complete
+	// - Rx BDs still armed after RXEOF stay in hardware. The next runStart() takes them over if its Rx range continues where
+	//   they begin (see dmaFeedBasic::getRxBytesConsumed()), otherwise it halts S2MM and retires them (MM2S runs on). Only
+	//   if data arrived in between does it reset the DMA. The source must not send between the transactions
+	bool rxCompleteOnEof = false;
+	// fills BDs with dmaBdTemplate::stamp() and flushes contiguous chunks of one queue() call together, instead of one driver
+	// call per BD field and one flush per chunk. false: driver calls (reference, see benchmark)
+	bool fastBdFill = true;
+	// replay (see dmaFeedBasic::runReplay()): runStart() sizes both rings to exactly its transaction and the BDs it programs
+	// stay in place. Needs all BDs of a transaction in one ring (nBytesAllocTxBd / nBytesAllocRxBd). Not with rxCompleteOnEof,
+	// needs both channels
+	bool replay = false;
+	// interrupt callbacks specialized for dmaFeedBasic (dmaFeedStatic: collect / queue inlined). false: through the vtable
+	// (reference, see benchmark)
+	bool inlineIsr = true;
+	// resume after DMA error: run_poll() rebuilds the rings and continues the transaction from the last confirmed offset (see
+	// dmaFeedBasic::getTxBytesConfirmed()) up to this many times per transaction, then reports DMAFEED_IDLE_ERROR.
+	// 0: reports the first error (the application restarts the whole transaction). Not with rxCompleteOnEof
+	unsigned int resumeMaxRetries = 0;
+	// resume: Rx data is the Tx data passed through in order (loopback, streaming filter) => both channels resume at the lower
+	// of the two confirmed offsets (same segment sizes on both sides). Needs the stream FIFO reset with the DMA (wired to
+	// s2mm_prmry_reset_out_n), otherwise Tx data still in it arrives ahead of the resent data. false: independent source /
+	// sink, each channel resumes at its own offset. Ignored with one channel
+	bool resumeLinked = true;
 };
 
 // sends and receives a predetermined amount of data from and to memory
-class dmaFeedBasic: public dmaFeedBase{
+// Tx only (playout) / Rx only (capture): clear dmaFeedBaseConfig::useRx / useTx, and pass no data for that channel to runStart()
+// cache maintenance is per BD: Tx chunks are flushed when queued, Rx chunks invalidated when collected
+// (fastBdFill: contiguous chunks queued together are flushed together; none with -DDMAFEED_COHERENT=1, see dmaFeedPolicy)
+class dmaFeedBasic: public dmaFeedStatic<dmaFeedBasic>{
 public:
 	dmaFeedBasic(const dmaFeedBasicConfig& config);
 	void runStart(char* txBuf, u32 numTxBytes, char* rxBuf, u32 numRxBytes);
+
+	// one contiguous piece of a scatter / gather list
+	typedef struct {
+		char* addr;
+		u32 nBytes;
+	} segment_t;
+
+	// gathers Tx data from / scatters Rx data into segment lists without copying (BDs point into the segments; a segment
+	// larger than maxPacketSize spans several BDs). Segment arrays must stay valid until the transaction completes.
+	// Tx packets end on BD boundaries and end the Rx BD they arrive in => with a loopback, use the same segment sizes on both sides.
+	void runStart(const segment_t* txSegs, unsigned int nTxSegs, const segment_t* rxSegs, unsigned int nRxSegs);
+
+	// repeats the transaction of the last runStart() (same segments and lengths) without programming BDs: the Tx chain is
+	// resubmitted as recorded (BdRingToHw() clears the status words and moves the tail pointer). Flushes Tx data and Rx buffers
+	// (may have been written since), then arms the Rx chain ahead of the Tx chain. Needs dmaFeedBasicConfig::replay. After an
+	// error, records again (as runStart())
+	void runReplay();
+
+	// received bytes of the current / last transaction (actual lengths from BD status)
+	u32 getRxBytesReceived() const {return nRxBytesReceived;}
+
+	// rxCompleteOnEof: Rx range taken by the packet in whole BDs (through the BD with RXEOF). The BDs still armed begin right
+	// after it => a next runStart() whose Rx segments continue there with the same BD split (e.g. rxBuf + getRxBytesConsumed(),
+	// reaching at least as far as the last range) adopts them without a DMA reset, as long as no data arrived in between
+	u32 getRxBytesConsumed() const {return nRxBytesConsumed;}
+
+	// confirmed offsets of the current / last transaction: data up to here completed in order without error. After a DMA
+	// error, including BDs the hardware completed before it halted. rxCompleteOnEof: Rx as getRxBytesReceived()
+	u32 getTxBytesConfirmed() const {return nTxBytesTotal - nTxBytesRemainingToComplete;}
+	u32 getRxBytesConfirmed() const {return rxCompleteOnEof ? nRxBytesReceived : nRxBytesTotal - nRxBytesRemainingToComplete;}
+
+	// Tx bytes of the current / last transaction handed to BDs so far (after a DMA error: up to where queueing had got)
+	u32 getTxBytesQueued() const {return nTxBytesTotal - nTxBytesRemainingToQueue;}
+
+	// resumes in the current / last transaction, and Tx bytes they queued a second time (from the resume offset up to where
+	// queueing had got at the error)
+	unsigned int getNResumes() const {return nResumes;}
+	u32 getTxBytesRetransmitted() const {return nTxBytesRetransmitted;}
 private:
+	friend class dmaFeedStatic<dmaFeedBasic>;
 	void collectTx() override final;
 	void collectRx() override final;
 	void queue(bool txFlag, bool rxFlag) override final;
+	// resume after DMA error (see dmaFeedBasicConfig::resumeMaxRetries): continues the transaction while retries are left
+	bool onError() override final;
 	void queueTx(); // splitting queue() in two for readability
 	void queueRx(); // splitting queue() in two for readability
 
@@ -34,11 +105,61 @@ private:
 	// remaining number of inbound bytes pending completion
 	u32 nRxBytesRemainingToComplete = 0;
 
-	// running pointer into outbound data
-	char* txPtr = NULL;
+	// see getRxBytesReceived()
+	u32 nRxBytesReceived = 0;
+
+	const bool rxCompleteOnEof;
+	// see getRxBytesConsumed()
+	u32 nRxBytesConsumed = 0;
+
+	// position in a segment list
+	typedef struct {
+		const segment_t* seg; // current segment
+		const segment_t* segEnd; // one past last segment
+		u32 offset; // bytes of current segment already assigned to BDs
+	} cursor_t;
 
-	// running pointer into inbound data
-	char* rxPtr = NULL;
+	// running position in outbound data
+	cursor_t txCursor = {};
+
+	// running position in inbound data
+	cursor_t rxCursor = {};
+
+	// rxCompleteOnEof: whether the Rx BDs still in hardware are the first BDs of the Rx range at c and none has completed yet.
+	// If so, advances c past them and returns their bytes in nBytes
+	bool adoptRxBds(cursor_t& c, u32& nBytes);
+	// rxCompleteOnEof: halts S2MM and returns the Rx BDs still in hardware to the free pool, unused. The ring restarts with the
+	// next BDs queued. Returns false if one has completed since (data arrived between the transactions)
+	bool retireRxBds();
+
+	// segment list for runStart() with contiguous buffers
+	segment_t txSingle = {};
+	segment_t rxSingle = {};
+
+	// === resume after error (see dmaFeedBasicConfig::resumeMaxRetries) ===
+	const unsigned int resumeMaxRetries;
+	const bool resumeLinked;
+	// transaction of the last runStart() / runReplay(): segment lists from the start, and sizes
+	cursor_t txBegin = {};
+	cursor_t rxBegin = {};
+	u32 nTxBytesTotal = 0;
+	u32 nRxBytesTotal = 0;
+	// see getNResumes(), getTxBytesRetransmitted()
+	unsigned int nResumes = 0;
+	u32 nTxBytesRetransmitted = 0;
+	// after an error reset: bytes of the BDs the hardware completed before halting, from the ring head (not yet collected).
+	// Walks the BDs directly: BdRingFromHw() would hold back a partially completed packet. The ring is rebuilt anyway
+	u32 salvageCompleted(XAxiDma_BdRing* ringPtr, bool isRx);
+	// rebuilds the rings and continues from the confirmed offsets
+	void resume();
+	// cursor at offset bytes into the segment list
+	static cursor_t cursorAt(cursor_t c, u32 offset);
+
+	// BDs needed for the rest of the segment list (not exceeding nBufAvailable)
+	unsigned int segmentsToBufs(cursor_t c, unsigned int nBufAvailable) const;
+
+	// next chunk for one BD, at most maxPacketSize and not crossing segments. Advances c
+	void nextChunk(cursor_t& c, char*& addr, u32& nBytes) const;
 
 	// txHandler sets this flag when all Tx data has been queued
 	volatile bool txDone = false;
@@ -46,9 +167,26 @@ private:
 	// rxHandler sets this flag when all Rx data has been received
 	volatile bool rxDone = false;
 
-	// need retval buffers to transmit given nr. bytes (not exceeding nBufAvailable)
-	unsigned int bytesToBufs(unsigned int nBytes, unsigned int nBufAvailable) const;
-
 	const unsigned int maxPacketSize;
+
+	// see dmaFeedBasicConfig::fastBdFill
+	const bool fastBdFill;
+	const dmaBdTemplate bdTemplate;
+
+	// === replay (see dmaFeedBasicConfig::replay) ===
+	const bool replay;
+	// runStart() programmed the rings with this transaction (valid while bdRingsAreUp())
+	bool replayRecorded = false;
+	cursor_t txRecorded = {};
+	cursor_t rxRecorded = {};
+	u32 nTxBytesRecorded = 0;
+	u32 nRxBytesRecorded = 0;
+	// runReplay(): next queueTx() / queueRx() resubmits the recorded chain
+	bool txReplayPending = false;
+	bool rxReplayPending = false;
+	// allocates and submits all BDs of an exactly sized ring, as recorded
+	void replayToHw(XAxiDma_BdRing* ringPtr, bool isRx);
+	// flushes the data cache over a segment list
+	static void flushSegments(cursor_t c);
 };
 #endif
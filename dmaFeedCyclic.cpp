@@ -0,0 +1,138 @@
+#include "dmaFeedCyclic.h"
+
+namespace {
+// base configuration: Rx only, cyclic Rx ring of exactly nBuffers BDs, coalescing count of one wrap (irqPerWrap)
+dmaFeedBaseConfig cyclicBaseConfig(const dmaFeedCyclicConfig& config){
+	dmaFeedBaseConfig c = config;
+	c.useTx = false;
+	c.useRx = true;
+	c.rxCyclic = true;
+	c.nBytesAllocRxBd = config.nBuffers * XAXIDMA_BD_MINIMUM_ALIGNMENT;
+	if (config.irqPerWrap)
+		c.coalesceNRxInterrupts = config.nBuffers;
+	return c;
+}
+} // namespace
+
+dmaFeedCyclic::dmaFeedCyclic(const dmaFeedCyclicConfig& config, char* pool) : dmaFeedBase(cyclicBaseConfig(config)),
+	pool(pool), nBuffers(config.nBuffers), bufferSize(config.bufferSize){
+	assert((nBuffers >= 2) && bufferSize && "need at least two buffers"); // overrun detection looks at the BD behind the reader
+	assert(bufferSize <= rxRingPtr->MaxTransferLen && "bufferSize exceeds DMA length register");
+	assert((!config.irqPerWrap || ((nBuffers <= XAXIDMA_COALESCE_MAX) && !config.coalesceAdaptive)) && "irqPerWrap: up to 255 buffers, no adaptive coalescing");
+	assert(((u32)XAxiDma_BdRingGetCnt(rxRingPtr) == nBuffers) && "cyclic ring must have one BD per buffer");
+	assert(!(bufferSize % DMAFEED_CACHE_LINE) && "bufferSize must be a multiple of DMAFEED_CACHE_LINE"); // buffers share no cache line
+	if (!this->pool){
+		// stride == bufferSize (whole cache lines) => contiguous, as a pool from the application
+		ownedPool = new dmaBufferPool(bufferSize, nBuffers);
+		this->pool = ownedPool->getBuffer(0);
+	}
+}
+
+dmaFeedCyclic::~dmaFeedCyclic(){
+	// DMA must not write into the pool after it is freed
+	runStop();
+	delete ownedPool;
+}
+
+void dmaFeedCyclic::setNotify(notify_t notify, void* context){
+	assert(!running);
+	this->notify = notify;
+	notifyContext = context;
+}
+
+void dmaFeedCyclic::runStart(){
+	runStop(); // restart: rebuilt ring, all BD status words clear
+	readIx = 0;
+	armed = false;
+	running = true;
+	dmaFeedBase::runStart();
+}
+
+void dmaFeedCyclic::runStop(){
+	if (!running)
+		return;
+	abort();
+	running = false;
+}
+
+bool dmaFeedCyclic::getFilled(unsigned int& bufIx, char*& data, u32& nBytes, bool& eop){
+	if (!running || doneFlag)
+		return false; // stopped, or reset after DMA error
+	u32 bdStatus = XAxiDma_BdRead(bufferBd(readIx), XAXIDMA_BD_STS_OFFSET);
+	if (!(bdStatus & XAXIDMA_BD_STS_COMPLETE_MASK))
+		return false;
+	assert(!(bdStatus & XAXIDMA_BD_STS_ALL_ERR_MASK));
+	bufIx = readIx;
+	data = bufferAddr(readIx);
+	nBytes = bdStatus & rxRingPtr->MaxTransferLen;
+	eop = bdStatus & XAXIDMA_BD_STS_RXEOF_MASK;
+
+	// lines may be left from reading the previous wrap, or speculatively fetched
+	Xil_DCacheInvalidateRange((INTPTR)data, nBytes);
+	statsBytes(/*isRx*/true, nBytes);
+	return true;
+}
+
+bool dmaFeedCyclic::release(){
+	assert(running && bdIsComplete(readIx) && "release() without getFilled()");
+	XAxiDma_BdWrite(bufferBd(readIx), XAXIDMA_BD_STS_OFFSET, 0);
+	// the BD behind was acknowledged before => complete again only if the hardware has finished it once more, and has moved
+	// on into the released buffer
+	unsigned int prevIx = readIx ? readIx - 1 : nBuffers - 1;
+	readIx = (readIx + 1 == nBuffers) ? 0 : readIx + 1;
+	return !bdIsComplete(prevIx);
+}
+
+unsigned int dmaFeedCyclic::getWriteIndex() const{
+	unsigned int ix = readIx + getNFilled();
+	return (ix >= nBuffers) ? ix - nBuffers : ix;
+}
+
+unsigned int dmaFeedCyclic::getNFilled() const{
+	unsigned int n = 0;
+	for (unsigned int ix = readIx; (n < nBuffers) && bdIsComplete(ix); ix = (ix + 1 == nBuffers) ? 0 : ix + 1)
+		++n;
+	return n;
+}
+
+void dmaFeedCyclic::collectTx()/*override*/{
+	// Tx unused
+}
+
+void dmaFeedCyclic::collectRx()/*override*/{
+	// BDs stay in hardware for good => nothing to collect
+	if (notify)
+		notify(notifyContext);
+}
+
+void dmaFeedCyclic::queue(bool txEvent, bool rxEvent)/*override*/{
+	(void)txEvent; // Tx unused
+	(void)rxEvent;
+	if (armed)
+		return;
+
+	int s;
+	XAxiDma_Bd* firstBdPtr;
+	s = XAxiDma_BdRingAlloc(rxRingPtr, nBuffers, &firstBdPtr); assert (s == XST_SUCCESS && "DMA cyclic: BdRingAlloc() failed");
+	assert((firstBdPtr == bufferBd(0)) && "DMA cyclic: ring not fresh");
+	XAxiDma_Bd* itBdPtr = firstBdPtr;
+
+	for (unsigned int bufIx = 0; bufIx < nBuffers; ++bufIx){
+		char* data = bufferAddr(bufIx);
+
+		// no dirty lines may be evicted over DMA data
+		Xil_DCacheInvalidateRange((INTPTR)data, bufferSize);
+
+		s = XAxiDma_BdSetBufAddr(itBdPtr, (UINTPTR)data); assert (s == XST_SUCCESS && "DMA cyclic: BdSetBufAddr() failed");
+		s = XAxiDma_BdSetLength(itBdPtr, bufferSize, rxRingPtr->MaxTransferLen); assert (s == XST_SUCCESS && "DMA cyclic: BdSetLength() failed");
+		XAxiDma_BdSetCtrl(itBdPtr, 0); // unnecessary (HW will set)
+		XAxiDma_BdSetId(itBdPtr, bufIx);
+
+		itBdPtr = (XAxiDma_Bd*)XAxiDma_BdRingNext(rxRingPtr, itBdPtr); assert(itBdPtr);
+	}
+
+	// starts the hardware, which then ignores the tail pointer
+	s = XAxiDma_BdRingToHw(rxRingPtr, nBuffers, firstBdPtr); assert (s == XST_SUCCESS && "DMA cyclic: BdRingToHw() failed");
+	trace(dmaTrace::TRACE_TO_HW, /*isRx*/true, nBuffers);
+	armed = true;
+}
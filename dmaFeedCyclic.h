@@ -0,0 +1,91 @@
+#ifndef DMAFEEDCYCLIC_H
+#define DMAFEEDCYCLIC_H
+#include "dmaFeedBase.h"
+#include "dmaBufferPool.h"
+
+// all fields may be optionally configured before passing to dmaFeed constructor
+class dmaFeedCyclicConfig: public dmaFeedBaseConfig{
+public:
+	dmaFeedCyclicConfig(unsigned int dmaDevId, unsigned int txIntrId, unsigned int rxIntrId) : dmaFeedBaseConfig(dmaDevId, txIntrId, rxIntrId){
+	}
+	// number of buffers in the ring, one Rx BD each (the Rx ring is sized to exactly nBuffers, nBytesAllocRxBd is ignored)
+	u32 nBuffers = 16;
+	// size of one buffer in bytes. Up to configured width of DMA length register. Multiple of the cache line size.
+	u32 bufferSize = 1 << 13;
+	// IRQ / HYBRID completion: Rx coalescing count of nBuffers (up to 255) => one interrupt per ring wrap if the source ends a
+	// packet (TLAST) per buffer. false: coalesceNRxInterrupts / coalesceDelayRx as configured
+	bool irqPerWrap = true;
+};
+
+// endless S2MM capture into a fixed ring of buffers in cyclic BD mode (dmaFeedBaseConfig::rxCyclic)
+// - runStart() arms one BD per buffer, once. The hardware then loops over the ring on its own: no BD is collected or re-armed,
+//   interrupts only wake up the reader (see setNotify()). With DMAFEED_COMPLETION_POLL there are none at all.
+// - the application reads behind the hardware: getFilled() returns the buffer at the read position once its BD status reports
+//   completion, release() acknowledges it (clears the status word) and advances the read position
+// - nothing throttles the hardware. When it laps the reader, release() reports the overrun: the released buffer may have been
+//   overwritten while it was read, data was lost. Restart with runStart().
+// A buffer ends when full or at TLAST (actual length and eop from the BD status). DMA errors show in run_poll(), as for any
+// dmaFeed; call it now and then in IRQ mode, too. The Tx channel is unused (no ring, no interrupt, see dmaFeedBaseConfig::useTx).
+class dmaFeedCyclic: public dmaFeedBase{
+public:
+	// called in interrupt context (IRQ mode) or from run_poll() (polling and deferred modes), after new buffers may have been completed
+	typedef void (*notify_t)(void* context);
+
+	// pool: nBuffers * bufferSize bytes, cache line aligned, or NULL to allocate internally (dmaBufferPool).
+	// bufferSize: a multiple of DMAFEED_CACHE_LINE
+	dmaFeedCyclic(const dmaFeedCyclicConfig& config, char* pool = NULL);
+	~dmaFeedCyclic();
+
+	// optional reader wake-up. Set before runStart()
+	void setNotify(notify_t notify, void* context);
+
+	// arms all buffers and starts capture at buffer 0. Returns immediately; run_poll() stays DMAFEED_BUSY until runStop() or
+	// DMA error. Restarts a running capture (e.g. after an overrun or DMAFEED_IDLE_ERROR)
+	void runStart();
+
+	// stops capture and resets the DMA
+	void runStop();
+
+	// buffer at the read position, if its BD is complete. Returns false if not (yet), or if capture is stopped
+	bool getFilled(unsigned int& bufIx, char*& data, u32& nBytes, bool& eop);
+
+	// hands the buffer at the read position (from getFilled()) back to the hardware and advances the read position.
+	// Returns false if the hardware has overtaken the reader
+	bool release();
+
+	// next buffer for getFilled()
+	unsigned int getReadIndex() const {return readIx;}
+
+	// buffer the hardware writes next, from BD status: first incomplete BD from the read position on. Equals the read position
+	// when all BDs are complete (ring full)
+	unsigned int getWriteIndex() const;
+
+	// complete buffers ahead of the reader (nBuffers: ring full, the hardware overwrites the read position next)
+	unsigned int getNFilled() const;
+
+	char* bufferAddr(unsigned int bufIx) const {return pool + bufIx * bufferSize;}
+private:
+	void collectTx() override final;
+	void collectRx() override final;
+	void queue(bool txFlag, bool rxFlag) override final;
+
+	// BD of a buffer: runStart() arms the freshly built ring from its first BD => BD ix holds buffer ix
+	XAxiDma_Bd* bufferBd(unsigned int bufIx) const {return (XAxiDma_Bd*)(rxRingPtr->FirstBdAddr + bufIx * rxRingPtr->Separation);}
+	bool bdIsComplete(unsigned int bufIx) const {return XAxiDma_BdGetSts(bufferBd(bufIx)) & XAXIDMA_BD_STS_COMPLETE_MASK;}
+
+	notify_t notify = NULL;
+	void* notifyContext = NULL;
+
+	char* pool;
+	// pool allocated by the constructor, NULL if from the application
+	dmaBufferPool* ownedPool = NULL;
+	const u32 nBuffers;
+	const u32 bufferSize;
+
+	unsigned int readIx = 0;
+	// capture is active (between runStart() and runStop())
+	bool running = false;
+	// ring is armed (first queue() after runStart() done)
+	bool armed = false;
+};
+#endif
@@ -0,0 +1,70 @@
+#include "dmaFeedIntc.h"
+#include <cassert>
+
+bool dmaFeedIntc::initialized = false;
+#ifdef DMAFEED_HAS_INTC
+	XIntc dmaFeedIntc::iIntc;
+#endif
+#ifdef DMAFEED_HAS_SCUGIC
+	XScuGic dmaFeedIntc::iIntc;
+#endif
+
+void dmaFeedIntc::installGlobalIrqExceptionHandler(){
+	Xil_ExceptionInit();
+	// initialization disables all sources => before anything is connected
+	init();
+#ifdef DMAFEED_HAS_INTC
+	Xil_ExceptionRegisterHandler(XIL_EXCEPTION_ID_INT, (Xil_ExceptionHandler)XIntc_InterruptHandler, (void *)&iIntc);
+#endif
+#ifdef DMAFEED_HAS_SCUGIC
+	Xil_ExceptionRegisterHandler(XIL_EXCEPTION_ID_INT, (Xil_ExceptionHandler)XScuGic_InterruptHandler, (void *)&iIntc);
+#endif
+	Xil_ExceptionEnable();
+}
+
+#ifdef DMAFEED_HAS_INTC
+void dmaFeedIntc::init(){
+	if (initialized)
+		return;
+	int s; // generic state
+	s = XIntc_Initialize(&iIntc, DMAFEED_INTC_DEVICE_ID); assert(s == XST_SUCCESS && "XIntc_Initialize() failed");
+	s = XIntc_Start(&iIntc, XIN_REAL_MODE); assert(s == XST_SUCCESS && "XIntc_Start() failed");
+	initialized = true;
+}
+
+void dmaFeedIntc::connect(u32 intrId, Xil_InterruptHandler handler, void* context, int cpu){
+	(void)cpu; // single CPU
+	init();
+	int s = XIntc_Connect(&iIntc, intrId, (XInterruptHandler)handler, context); assert(s == XST_SUCCESS && "XIntc_Connect() failed");
+	XIntc_Enable(&iIntc, intrId);
+}
+
+void dmaFeedIntc::disconnect(u32 intrId){
+	assert(initialized);
+	XIntc_Disconnect(&iIntc, intrId);
+}
+#endif
+
+#ifdef DMAFEED_HAS_SCUGIC
+void dmaFeedIntc::init(){
+	if (initialized)
+		return;
+	XScuGic_Config *intcConfig = XScuGic_LookupConfig(DMAFEED_INTC_DEVICE_ID); assert(intcConfig && "DMA: XScuGic_LookupConfig() failed");
+	int s = XScuGic_CfgInitialize(&iIntc, intcConfig, intcConfig->CpuBaseAddress); assert(s == XST_SUCCESS && "DMA: XScuGic_CfgInitialize() failed");
+	initialized = true;
+}
+
+void dmaFeedIntc::connect(u32 intrId, Xil_InterruptHandler handler, void* context, int cpu){
+	init();
+	if (cpu >= 0)
+		XScuGic_InterruptMaptoCpu(&iIntc, (u8)cpu, intrId);
+	XScuGic_SetPriorityTriggerType(&iIntc, intrId, /*prio*/0xA0, /*rising edge*/0x3); // prio value from sample code
+	int s = XScuGic_Connect(&iIntc, intrId, handler, context); assert(s == XST_SUCCESS && "DMA: XScuGic_Connect() failed");
+	XScuGic_Enable(&iIntc, intrId);
+}
+
+void dmaFeedIntc::disconnect(u32 intrId){
+	assert(initialized);
+	XScuGic_Disconnect(&iIntc, intrId);
+}
+#endif
@@ -0,0 +1,47 @@
+#ifndef DMAFEEDINTC_H
+#define DMAFEEDINTC_H
+#include "xparameters.h"
+#include "xil_exception.h"
+
+// === determine type of interrupt controller ===
+#ifdef XPAR_INTC_0_DEVICE_ID
+#	define DMAFEED_HAS_INTC
+#	define DMAFEED_INTC_DEVICE_ID          XPAR_INTC_0_DEVICE_ID
+#	include "xintc.h"
+#else
+#	define DMAFEED_HAS_SCUGIC
+#	define DMAFEED_INTC_DEVICE_ID          XPAR_SCUGIC_SINGLE_DEVICE_ID
+#	include "xscugic.h"
+#endif
+
+// the interrupt controller, shared by all dmaFeed instances
+// - initialized once, on first use. Afterwards only individual sources are connected / disconnected
+//   => instances on different DMA engines run side by side without disturbing each other's interrupts
+// - application context, with interrupts masked (or before any source is enabled)
+class dmaFeedIntc{
+public:
+	// installs the controller's handler for the CPU IRQ exception and unmasks IRQs (once per application if not done elsewhere)
+	static void installGlobalIrqExceptionHandler();
+
+	// connects handler (rising edge) and enables the source
+	// cpu >= 0 (SCUGIC): also routes the source to that CPU (e.g. a core dedicated to DMA service, see dmaServiceCore). The
+	// distributor targets all sources at the CPU that initialized it, so this is needed only if another core did
+	static void connect(u32 intrId, Xil_InterruptHandler handler, void* context, int cpu = -1);
+
+	// disables the source and removes its handler
+	static void disconnect(u32 intrId);
+private:
+	dmaFeedIntc() = delete;
+
+	// initializes the controller unless done already
+	static void init();
+	static bool initialized;
+
+#ifdef DMAFEED_HAS_INTC
+	static XIntc iIntc; // interrupt controller "instance"
+#endif
+#ifdef DMAFEED_HAS_SCUGIC
+	static XScuGic iIntc; // interrupt controller "instance"
+#endif
+};
+#endif
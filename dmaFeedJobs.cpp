@@ -0,0 +1,270 @@
+#include "dmaFeedJobs.h"
+
+dmaFeedJobs::dmaFeedJobs(const dmaFeedJobsConfig& config) : dmaFeedBase(config),
+	submitted(config.nJobs), slots(new slot_t[config.nJobs]), nSlots(config.nJobs), maxPacketSize(config.maxPacketSize){
+	assert(nSlots && maxPacketSize);
+	assert((config.nRxChannels == 1) && "multichannel Rx needs dmaFeedStream");
+	assert(config.useTx && config.useRx && "jobs need both channels (Tx-only / Rx-only jobs use them in turn)");
+	assert(maxPacketSize <= txRingPtr->MaxTransferLen && "maxPacketSize exceeds DMA length register");
+}
+
+dmaFeedJobs::~dmaFeedJobs(){
+	// DMA must not access job buffers after callbacks reported them as done
+	runStop();
+	delete[] slots;
+}
+
+unsigned int dmaFeedJobs::bytesToBufs(u32 nBytes) const {
+	return (nBytes + maxPacketSize - 1) / maxPacketSize;
+}
+
+void dmaFeedJobs::runStart(){
+	runStop(); // e.g. restart after DMA error
+	head = txIx = rxIx = tail = 0;
+	nInFlight = 0;
+	nTxJobsToQueue = nRxJobsToQueue = 0;
+	running = true;
+	dmaFeedBase::runStart();
+}
+
+void dmaFeedJobs::runStop(){
+	if (!running)
+		return;
+	abort();
+	running = false;
+	failJobs();
+}
+
+void dmaFeedJobs::failJobs(){
+	while (nInFlight){
+		slot_t& s = slots[head];
+		head = nextSlot(head);
+		--nInFlight;
+		if (s.job.callback)
+			s.job.callback(s.job.context, /*ok*/false);
+	}
+	job_t job;
+	while (submitted.pop(job))
+		if (job.callback)
+			job.callback(job.context, /*ok*/false);
+}
+
+bool dmaFeedJobs::submit(const job_t& job){
+	assert((job.nTxBytes || job.nRxBytes) && "empty job");
+	assert(((uintptr_t)job.txBuf & 3) == 0); // check alignment
+	assert(((uintptr_t)job.rxBuf & 3) == 0); // check alignment
+	assert((bytesToBufs(job.nTxBytes) <= (u32)XAxiDma_BdRingGetCnt(txRingPtr)) && "job Tx packet needs more BDs than the Tx ring holds");
+
+	// DMA doesn't go through cache => must flush
+	Xil_DCacheFlushRange((INTPTR)job.txBuf, job.nTxBytes);
+	Xil_DCacheFlushRange((INTPTR)job.rxBuf, job.nRxBytes);
+
+	// queue() also runs from the interrupt callbacks
+	Xil_ExceptionDisable();
+	bool ok = submitted.push(job);
+	if (ok && running && !doneFlag)
+		queue(/*txEvent*/true, /*rxEvent*/true); // rings may have drained => no interrupt would pick up the job
+	Xil_ExceptionEnable();
+	return ok;
+}
+
+void dmaFeedJobs::admit(){
+	while (nInFlight < nSlots){
+		slot_t& s = slots[tail];
+		if (!submitted.pop(s.job))
+			break;
+		s.nRxBytesQueued = 0;
+		s.txQueued = s.rxQueued = false;
+		s.nTxBytesRemainingToComplete = s.job.nTxBytes;
+		s.nRxBytesRemainingToComplete = s.job.nRxBytes;
+		tail = nextSlot(tail);
+		++nInFlight;
+		++nTxJobsToQueue;
+		++nRxJobsToQueue;
+	}
+}
+
+void dmaFeedJobs::completeJobs(){
+	while (nInFlight){
+		slot_t& s = slots[head];
+		if (!s.txQueued || !s.rxQueued || s.nTxBytesRemainingToComplete || s.nRxBytesRemainingToComplete)
+			break; // jobs complete in order
+		head = nextSlot(head);
+		--nInFlight;
+		if (s.job.callback)
+			s.job.callback(s.job.context, /*ok*/true);
+	}
+}
+
+void dmaFeedJobs::collectTx()/*override*/{
+	XAxiDma_Bd *firstBdPtr; // first buffer descriptor in returned set
+	int nBd = XAxiDma_BdRingFromHw(txRingPtr, /*no limit to the number of returned BDs*/XAXIDMA_ALL_BDS, &firstBdPtr);
+	if (nBd)
+		trace(dmaTrace::TRACE_FROM_HW, /*isRx*/false, nBd);
+	XAxiDma_Bd *itBdPtr = firstBdPtr;
+
+	int bdCount = nBd;
+	while (bdCount--){
+		u32 bdStatus = XAxiDma_BdGetSts(itBdPtr);
+		assert(!(bdStatus & XAXIDMA_BD_STS_ALL_ERR_MASK));
+		assert(bdStatus & XAXIDMA_BD_STS_COMPLETE_MASK);
+		slot_t& s = slots[XAxiDma_BdGetId(itBdPtr)];
+		u32 n = XAxiDma_BdGetLength(itBdPtr, txRingPtr->MaxTransferLen);
+		assert(n <= s.nTxBytesRemainingToComplete);
+		s.nTxBytesRemainingToComplete -= n;
+		statsBytes(/*isRx*/false, n);
+		itBdPtr = (XAxiDma_Bd *)XAxiDma_BdRingNext(txRingPtr, itBdPtr);
+	}
+
+	// === return completed BDs to pool ===
+	int s = XAxiDma_BdRingFree(txRingPtr, nBd, firstBdPtr); assert(s == XST_SUCCESS && "XAxiDma_BdRingFree(Tx) failed");
+	completeJobs();
+}
+
+void dmaFeedJobs::collectRx()/*override*/{
+	XAxiDma_Bd *firstBdPtr; // first buffer descriptor in returned set
+	int nBd = XAxiDma_BdRingFromHw(rxRingPtr, /*no limit to the number of returned BDs*/XAXIDMA_ALL_BDS, &firstBdPtr);
+	if (nBd)
+		trace(dmaTrace::TRACE_FROM_HW, /*isRx*/true, nBd);
+	XAxiDma_Bd *itBdPtr = firstBdPtr;
+
+	int bdCount = nBd;
+	while (bdCount--){
+		u32 bdStatus = XAxiDma_BdGetSts(itBdPtr);
+		assert(!(bdStatus & XAXIDMA_BD_STS_ALL_ERR_MASK));
+		assert(bdStatus & XAXIDMA_BD_STS_COMPLETE_MASK);
+		slot_t& s = slots[XAxiDma_BdGetId(itBdPtr)];
+		u32 n = XAxiDma_BdGetLength(itBdPtr, rxRingPtr->MaxTransferLen);
+		// lines may have been speculatively fetched since the flush in submit() => invalidate before the callback reads the data
+		Xil_DCacheInvalidateRange((INTPTR)XAxiDma_BdGetBufAddr(itBdPtr), XAxiDma_BdGetActualLength(itBdPtr, rxRingPtr->MaxTransferLen));
+		assert(n <= s.nRxBytesRemainingToComplete);
+		s.nRxBytesRemainingToComplete -= n;
+		statsBytes(/*isRx*/true, n);
+		itBdPtr = (XAxiDma_Bd *)XAxiDma_BdRingNext(rxRingPtr, itBdPtr);
+	}
+
+	// === return completed BDs to pool ===
+	int s = XAxiDma_BdRingFree(rxRingPtr, nBd, firstBdPtr); assert(s == XST_SUCCESS && "XAxiDma_BdRingFree(Rx) failed");
+	completeJobs();
+}
+
+void dmaFeedJobs::queue(bool txEvent, bool rxEvent)/*override*/{
+	// jobs feed both rings => always service both
+	(void)txEvent;
+	(void)rxEvent;
+	admit();
+	queueTx();
+	queueRx();
+}
+
+void dmaFeedJobs::queueTx(){
+	// === count whole jobs that fit ===
+	// each job is one packet, and BdRingToHw() accepts only complete packets (TXSOF .. TXEOF)
+	unsigned int nFreeBd = XAxiDma_BdRingGetFreeCnt(txRingPtr);
+	unsigned int nBufsToQueue = 0;
+	unsigned int nJobsToQueue = 0;
+	unsigned int ix = txIx;
+	while (nJobsToQueue < nTxJobsToQueue){
+		unsigned int n = bytesToBufs(slots[ix].job.nTxBytes);
+		if (nBufsToQueue + n > nFreeBd)
+			break;
+		nBufsToQueue += n;
+		++nJobsToQueue;
+		ix = nextSlot(ix);
+	}
+
+	int s;
+	if (nBufsToQueue > 0){
+		XAxiDma_Bd *firstBdPtr; // first buffer descriptor in allocated set
+		s = XAxiDma_BdRingAlloc(txRingPtr, nBufsToQueue, &firstBdPtr); assert (s == XST_SUCCESS && "DMA queueTx: BdRingAlloc() failed");
+		XAxiDma_Bd* itBdPtr = firstBdPtr; // buffer descriptor iterating over allocated set
+
+		ix = txIx;
+		for (unsigned int ixJob = 0; ixJob < nJobsToQueue; ++ixJob, ix = nextSlot(ix)){
+			const job_t& job = slots[ix].job;
+			char* txPtr = job.txBuf;
+			u32 nBytesRemaining = job.nTxBytes;
+			bool isFirstBd = true;
+			while (nBytesRemaining){
+				u32 thisBufNBytes = maxPacketSize < nBytesRemaining ? maxPacketSize : nBytesRemaining;
+				bool isLastBd = (thisBufNBytes == nBytesRemaining);
+
+				s = XAxiDma_BdSetBufAddr(itBdPtr, (UINTPTR)txPtr); assert(s == XST_SUCCESS && "DMA queueTx: BdSetBufAddr() failed");
+				s = XAxiDma_BdSetLength(itBdPtr, thisBufNBytes, txRingPtr->MaxTransferLen); assert(s == XST_SUCCESS && "DMA queueTx: BdSetLength() failed");
+
+				// === flag first and last BD of the job ===
+				u32 crBits = 0;
+				if (isFirstBd){
+					isFirstBd = false;
+					crBits |= XAXIDMA_BD_CTRL_TXSOF_MASK;
+				}
+				if (isLastBd)
+					crBits |= XAXIDMA_BD_CTRL_TXEOF_MASK;
+				XAxiDma_BdSetCtrl(itBdPtr, crBits);
+
+				XAxiDma_BdSetId(itBdPtr, ix); // identifies job on completion
+
+				itBdPtr = (XAxiDma_Bd*)XAxiDma_BdRingNext(txRingPtr, itBdPtr); assert(itBdPtr);
+				txPtr += thisBufNBytes;
+				nBytesRemaining -= thisBufNBytes;
+			} // while job bytes remaining
+		} // for all jobs to queue
+
+		// === submit to hardware ===
+		s = XAxiDma_BdRingToHw(txRingPtr, nBufsToQueue, firstBdPtr); assert (s == XST_SUCCESS && "DMA queueTx: BdRingToHw() failed");
+		trace(dmaTrace::TRACE_TO_HW, /*isRx*/false, nBufsToQueue);
+	} // if bufs to queue
+
+	// Rx-only jobs (no BDs) pass as well
+	for (unsigned int ixJob = 0; ixJob < nJobsToQueue; ++ixJob, txIx = nextSlot(txIx))
+		slots[txIx].txQueued = true;
+	nTxJobsToQueue -= nJobsToQueue;
+}
+
+void dmaFeedJobs::queueRx(){
+	// === count BDs, jobs may be split over several calls ===
+	unsigned int nFreeBd = XAxiDma_BdRingGetFreeCnt(rxRingPtr);
+	unsigned int nBufsToQueue = 0;
+	unsigned int ix = rxIx;
+	for (unsigned int ixJob = 0; (ixJob < nRxJobsToQueue) && (nBufsToQueue < nFreeBd); ++ixJob, ix = nextSlot(ix))
+		nBufsToQueue += bytesToBufs(slots[ix].job.nRxBytes - slots[ix].nRxBytesQueued);
+	if (nBufsToQueue > nFreeBd)
+		nBufsToQueue = nFreeBd;
+
+	XAxiDma_Bd* firstBdPtr = NULL;
+	XAxiDma_Bd* itBdPtr = NULL;
+	int s;
+	if (nBufsToQueue > 0){
+		s = XAxiDma_BdRingAlloc(rxRingPtr, nBufsToQueue, &firstBdPtr); assert (s == XST_SUCCESS && "DMA queueRx: BdRingAlloc() failed");
+		itBdPtr = firstBdPtr;
+	}
+
+	// === assign BDs to jobs. Also passes Tx-only jobs (no BDs) ===
+	unsigned int count = nBufsToQueue;
+	while (nRxJobsToQueue){
+		slot_t& slot = slots[rxIx];
+		while (count && (slot.nRxBytesQueued < slot.job.nRxBytes)){
+			u32 nBytesRemaining = slot.job.nRxBytes - slot.nRxBytesQueued;
+			u32 n = maxPacketSize < nBytesRemaining ? maxPacketSize : nBytesRemaining;
+			s = XAxiDma_BdSetBufAddr(itBdPtr, (UINTPTR)(slot.job.rxBuf + slot.nRxBytesQueued)); assert (s == XST_SUCCESS && "DMA queueRx: BdSetBufAddr() failed");
+			s = XAxiDma_BdSetLength(itBdPtr, n, rxRingPtr->MaxTransferLen); assert (s == XST_SUCCESS && "DMA queueRx: BdSetLength() failed");
+			XAxiDma_BdSetCtrl(itBdPtr, 0); // unnecessary (HW will set)
+			XAxiDma_BdSetId(itBdPtr, rxIx); // identifies job on completion
+
+			slot.nRxBytesQueued += n;
+			--count;
+			itBdPtr = (XAxiDma_Bd*)XAxiDma_BdRingNext(rxRingPtr, itBdPtr); assert(itBdPtr);
+		}
+		if (slot.nRxBytesQueued < slot.job.nRxBytes)
+			break; // out of BDs
+		slot.rxQueued = true;
+		rxIx = nextSlot(rxIx);
+		--nRxJobsToQueue;
+	}
+	assert(!count);
+
+	if (nBufsToQueue > 0){
+		s = XAxiDma_BdRingToHw(rxRingPtr, nBufsToQueue, firstBdPtr); assert (s == XST_SUCCESS && "DMA queueRx: BdRingToHw() failed");
+		trace(dmaTrace::TRACE_TO_HW, /*isRx*/true, nBufsToQueue);
+	}
+}
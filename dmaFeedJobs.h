@@ -0,0 +1,112 @@
+#ifndef DMAFEEDJOBS_H
+#define DMAFEEDJOBS_H
+#include "dmaFeedBase.h"
+#include "spscQueue.h"
+
+// all fields may be optionally configured before passing to dmaFeed constructor
+class dmaFeedJobsConfig: public dmaFeedBaseConfig{
+public:
+	dmaFeedJobsConfig(unsigned int dmaDevId, unsigned int txIntrId, unsigned int rxIntrId) : dmaFeedBaseConfig(dmaDevId, txIntrId, rxIntrId){
+	}
+	u32 maxPacketSize = 1 << 13; // bytes per BD, up to configured width of DMA length register e.g. XPAR_AXI_DMA_0_SG_LENGTH_WIDTH
+	u32 nJobs = 64; // capacity of the submission queue, and number of jobs in hardware at the same time
+};
+
+// queue of independent transfers ("jobs"), each with its own completion callback
+// - the application submits jobs at any time between runStart() and runStop(); queue() keeps pulling jobs as BDs free up,
+//   so the hardware does not drain between jobs
+// - the Tx data of a job is one packet (TXSOF on its first BD, TXEOF on its last) => must fit into the Tx BD ring
+// - Rx BDs are assigned to jobs in order. A job's Rx is complete when all its Rx BDs are, so Rx lengths should match the
+//   incoming packets (e.g. loopback: nRxBytes == nTxBytes)
+// - jobs complete in submission order
+class dmaFeedJobs: public dmaFeedBase{
+public:
+	// called once per job: ok==true from interrupt context (run_poll() in polling / deferred mode) after the job's Tx and Rx BDs completed,
+	// ok==false from runStop() / runStart() for jobs that were still outstanding (e.g. after DMAFEED_IDLE_ERROR)
+	typedef void (*jobCallback_t)(void* context, bool ok);
+
+	typedef struct {
+		char* txBuf;
+		u32 nTxBytes; // 0: Rx-only job
+		char* rxBuf;
+		u32 nRxBytes; // 0: Tx-only job
+		jobCallback_t callback; // may be NULL
+		void* context; // callback argument
+	} job_t;
+
+	dmaFeedJobs(const dmaFeedJobsConfig& config);
+	~dmaFeedJobs();
+
+	// starts processing of submitted jobs. Returns immediately; run_poll() stays DMAFEED_BUSY until runStop() or DMA error.
+	// Restarts a running instance (e.g. after DMAFEED_IDLE_ERROR), failing all outstanding jobs.
+	void runStart();
+
+	// resets the DMA and fails all outstanding jobs
+	void runStop();
+
+	// queues a job. Returns false if the submission queue is full. Buffers must stay valid until the callback.
+	// Do not call from a job callback.
+	bool submit(const job_t& job);
+
+	// jobs submitted but not yet completed (snapshot)
+	unsigned int nJobsPending() const {return submitted.size() + nInFlight;}
+private:
+	void collectTx() override final;
+	void collectRx() override final;
+	void queue(bool txFlag, bool rxFlag) override final;
+	void queueTx(); // splitting queue() in two for readability
+	void queueRx(); // splitting queue() in two for readability
+
+	// moves submitted jobs into free slots
+	void admit();
+
+	// retires jobs at head whose Tx and Rx are complete, in order
+	void completeJobs();
+
+	// fails outstanding jobs
+	void failJobs();
+
+	// need retval buffers to transmit given nr. bytes
+	unsigned int bytesToBufs(u32 nBytes) const;
+
+	unsigned int nextSlot(unsigned int ix) const {return (ix + 1 == nSlots) ? 0 : ix + 1;}
+
+	// job in hardware. Slot index is the BD ID
+	typedef struct {
+		job_t job;
+		// bytes assigned to Rx BDs (Tx goes in one piece)
+		u32 nRxBytesQueued;
+		// queueTx() / queueRx() are done with the job (also for zero bytes)
+		bool txQueued;
+		bool rxQueued;
+		// bytes pending completion
+		u32 nTxBytesRemainingToComplete;
+		u32 nRxBytesRemainingToComplete;
+	} slot_t;
+
+	// application => interrupt
+	spscQueue<job_t> submitted;
+
+	// ring of jobs in hardware (interrupt context only, or application with interrupts disabled)
+	slot_t* const slots;
+	const unsigned int nSlots;
+	// oldest job, next to complete
+	unsigned int head = 0;
+	// next job to queue Tx BDs for
+	unsigned int txIx = 0;
+	// next job to queue Rx BDs for
+	unsigned int rxIx = 0;
+	// next free slot
+	unsigned int tail = 0;
+	volatile unsigned int nInFlight = 0;
+	// admitted jobs without queued Tx BDs
+	unsigned int nTxJobsToQueue = 0;
+	// admitted jobs without all Rx BDs queued
+	unsigned int nRxJobsToQueue = 0;
+
+	const u32 maxPacketSize;
+
+	// between runStart() and runStop()
+	bool running = false;
+};
+#endif
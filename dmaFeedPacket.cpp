@@ -0,0 +1,248 @@
+#include "dmaFeedPacket.h"
+#include <cstdlib>
+
+dmaFeedPacket::dmaFeedPacket(const dmaFeedPacketConfig& config, char* pool) : dmaFeedBase(config),
+	txSubmitted(config.nTxPackets), txTags(XAxiDma_BdRingGetCnt(txRingPtr)), toArm(config.nRxBuffers), frags(new fragment_t[config.nRxBuffers]), pool(pool),
+	nRxBuffers(config.nRxBuffers), rxBufferSize(config.rxBufferSize), maxPacketSize(config.maxPacketSize){
+	assert(nRxBuffers && rxBufferSize && maxPacketSize);
+	assert((config.nRxChannels == 1) && "multichannel Rx needs dmaFeedStream");
+	assert(config.useTx && config.useRx && "packets need both channels");
+	assert(maxPacketSize <= txRingPtr->MaxTransferLen && "maxPacketSize exceeds DMA length register");
+	assert(rxBufferSize <= rxRingPtr->MaxTransferLen && "rxBufferSize exceeds DMA length register");
+	assert((u32)XAxiDma_BdRingGetCnt(rxRingPtr) >= nRxBuffers && "need one Rx BD per buffer, increase nBytesAllocRxBd");
+	if (!this->pool){
+		this->pool = (char*)aligned_alloc(XAXIDMA_BD_MINIMUM_ALIGNMENT, nRxBuffers * rxBufferSize);
+		assert(this->pool && "aligned_alloc failed");
+		poolIsOwned = true;
+	}
+}
+
+dmaFeedPacket::~dmaFeedPacket(){
+	// DMA must not write into the pool after it is freed
+	runStop();
+	if (poolIsOwned)
+		free(pool);
+	delete[] frags;
+}
+
+unsigned int dmaFeedPacket::bytesToBufs(u32 nBytes) const {
+	return (nBytes + maxPacketSize - 1) / maxPacketSize;
+}
+
+void dmaFeedPacket::setTxDone(txDone_t txDone, void* context){
+	assert(!running);
+	this->txDone = txDone;
+	txDoneContext = context;
+}
+
+void dmaFeedPacket::setRxPacket(rxPacket_t rxPacket, void* context){
+	assert(!running);
+	this->rxPacket = rxPacket;
+	rxPacketContext = context;
+}
+
+void dmaFeedPacket::runStart(){
+	runStop(); // e.g. restart after DMA error
+	txSubmitted.clear();
+	txTags.clear();
+	toArm.clear();
+	for (unsigned int ix = 0; ix < nRxBuffers; ++ix)
+		toArm.push(ix);
+	nFrags = 0;
+	nPacketBytes = 0;
+	packetTruncated = false;
+	running = true;
+	dmaFeedBase::runStart();
+}
+
+void dmaFeedPacket::runStop(){
+	if (!running)
+		return;
+	abort();
+	running = false;
+}
+
+bool dmaFeedPacket::sendPacket(char* data, u32 nBytes, void* tag){
+	assert(nBytes && "empty packet");
+	assert(((uintptr_t)data & 3) == 0); // check alignment
+	assert((bytesToBufs(nBytes) <= (u32)XAxiDma_BdRingGetCnt(txRingPtr)) && "packet needs more BDs than the Tx ring holds");
+
+	// DMA doesn't go through cache => must flush
+	Xil_DCacheFlushRange((INTPTR)data, nBytes);
+
+	// queueTx() also runs from the interrupt callbacks
+	Xil_ExceptionDisable();
+	txPacket_t p = {data, nBytes, tag};
+	bool ok = txSubmitted.push(p);
+	if (ok && running && !doneFlag)
+		queueTx(); // ring may have drained => no interrupt would pick up the packet
+	Xil_ExceptionEnable();
+	return ok;
+}
+
+void dmaFeedPacket::collectTx()/*override*/{
+	XAxiDma_Bd *firstBdPtr; // first buffer descriptor in returned set
+	int nBd = XAxiDma_BdRingFromHw(txRingPtr, /*no limit to the number of returned BDs*/XAXIDMA_ALL_BDS, &firstBdPtr);
+	if (nBd)
+		trace(dmaTrace::TRACE_FROM_HW, /*isRx*/false, nBd);
+	XAxiDma_Bd *itBdPtr = firstBdPtr;
+
+	int bdCount = nBd;
+	while (bdCount--){
+		u32 bdStatus = XAxiDma_BdGetSts(itBdPtr);
+		assert(!(bdStatus & XAXIDMA_BD_STS_ALL_ERR_MASK));
+		assert(bdStatus & XAXIDMA_BD_STS_COMPLETE_MASK);
+		statsBytes(/*isRx*/false, XAxiDma_BdGetLength(itBdPtr, txRingPtr->MaxTransferLen));
+		// packets complete in order
+		if (XAxiDma_BdGetCtrl(itBdPtr) & XAXIDMA_BD_CTRL_TXEOF_MASK){
+			void* tag = NULL;
+			bool ok = txTags.pop(tag); assert(ok); (void)ok;
+			if (txDone)
+				txDone(txDoneContext, tag);
+		}
+		itBdPtr = (XAxiDma_Bd *)XAxiDma_BdRingNext(txRingPtr, itBdPtr);
+	}
+
+	// === return completed BDs to pool ===
+	int s = XAxiDma_BdRingFree(txRingPtr, nBd, firstBdPtr); assert(s == XST_SUCCESS && "XAxiDma_BdRingFree(Tx) failed");
+}
+
+void dmaFeedPacket::collectRx()/*override*/{
+	// BdRingFromHw() returns whole packets only (up to the last RXEOF)
+	XAxiDma_Bd *firstBdPtr; // first buffer descriptor in returned set
+	int nBd = XAxiDma_BdRingFromHw(rxRingPtr, /*no limit to the number of returned BDs*/XAXIDMA_ALL_BDS, &firstBdPtr);
+	if (nBd)
+		trace(dmaTrace::TRACE_FROM_HW, /*isRx*/true, nBd);
+	XAxiDma_Bd *itBdPtr = firstBdPtr;
+
+	int bdCount = nBd;
+	while (bdCount--){
+		u32 bdStatus = XAxiDma_BdGetSts(itBdPtr);
+		assert(bdStatus & XAXIDMA_BD_STS_COMPLETE_MASK);
+		unsigned int bufIx = XAxiDma_BdGetId(itBdPtr);
+		u32 n = XAxiDma_BdGetActualLength(itBdPtr, rxRingPtr->MaxTransferLen);
+		itBdPtr = (XAxiDma_Bd *)XAxiDma_BdRingNext(rxRingPtr, itBdPtr);
+
+		// === reassemble RXSOF .. RXEOF ===
+		if (!nFrags && !(bdStatus & XAXIDMA_BD_STS_RXSOF_MASK))
+			packetTruncated = true;
+		if (bdStatus & XAXIDMA_BD_STS_ALL_ERR_MASK)
+			packetTruncated = true;
+
+		// lines may have been speculatively fetched while the DMA wrote the buffer
+		char* data = bufferAddr(bufIx);
+		Xil_DCacheInvalidateRange((INTPTR)data, n);
+		assert(nFrags < nRxBuffers);
+		frags[nFrags].addr = data;
+		frags[nFrags].nBytes = n;
+		++nFrags;
+		nPacketBytes += n;
+		statsBytes(/*isRx*/true, n);
+
+		if (bdStatus & XAXIDMA_BD_STS_RXEOF_MASK){
+			if (rxPacket)
+				rxPacket(rxPacketContext, frags, nFrags, nPacketBytes, packetTruncated);
+			// buffers go back to the pool
+			for (unsigned int ix = 0; ix < nFrags; ++ix)
+				toArm.push((frags[ix].addr - pool) / rxBufferSize);
+			nFrags = 0;
+			nPacketBytes = 0;
+			packetTruncated = false;
+		}
+	}
+
+	// === return completed BDs to pool (buffers are tracked separately) ===
+	int s = XAxiDma_BdRingFree(rxRingPtr, nBd, firstBdPtr); assert(s == XST_SUCCESS && "XAxiDma_BdRingFree(Rx) failed");
+}
+
+void dmaFeedPacket::queue(bool txEvent, bool rxEvent)/*override*/{
+	if (txEvent)
+		queueTx();
+	if (rxEvent)
+		queueRx();
+}
+
+void dmaFeedPacket::queueTx(){
+	// whole packets only: BdRingToHw() accepts complete packets (TXSOF .. TXEOF), and a packet is never split over two calls
+	// => framing does not depend on the number of free BDs
+	unsigned int nFreeBd = XAxiDma_BdRingGetFreeCnt(txRingPtr);
+	unsigned int nBufsToQueue = 0;
+	XAxiDma_Bd *firstBdPtr = NULL; // first buffer descriptor of all packets in this call
+	int s;
+	txPacket_t p;
+	while (txSubmitted.peek(p)){
+		unsigned int nBufs = bytesToBufs(p.nBytes);
+		if (nBufsToQueue + nBufs > nFreeBd)
+			break; // stays queued until BDs free up
+		txSubmitted.pop(p);
+		bool ok = txTags.push(p.tag); assert(ok); (void)ok; // one BD per packet at least => cannot overflow
+
+		XAxiDma_Bd *itBdPtr; // consecutive allocations are contiguous in the ring => one BdRingToHw() for all
+		s = XAxiDma_BdRingAlloc(txRingPtr, nBufs, &itBdPtr); assert (s == XST_SUCCESS && "DMA queueTx: BdRingAlloc() failed");
+		if (!firstBdPtr)
+			firstBdPtr = itBdPtr;
+		nBufsToQueue += nBufs;
+
+		char* txPtr = p.data;
+		u32 nBytesRemaining = p.nBytes;
+		for (unsigned int ix = 0; ix < nBufs; ++ix){
+			u32 thisBufNBytes = maxPacketSize < nBytesRemaining ? maxPacketSize : nBytesRemaining;
+			bool isFirstBd = !ix;
+			bool isLastBd = (ix == nBufs - 1);
+
+			s = XAxiDma_BdSetBufAddr(itBdPtr, (UINTPTR)txPtr); assert(s == XST_SUCCESS && "DMA queueTx: BdSetBufAddr() failed");
+			s = XAxiDma_BdSetLength(itBdPtr, thisBufNBytes, txRingPtr->MaxTransferLen); assert(s == XST_SUCCESS && "DMA queueTx: BdSetLength() failed");
+
+			// === flag first and last BD of the packet ===
+			u32 crBits = 0;
+			if (isFirstBd)
+				crBits |= XAXIDMA_BD_CTRL_TXSOF_MASK;
+			if (isLastBd)
+				crBits |= XAXIDMA_BD_CTRL_TXEOF_MASK;
+			XAxiDma_BdSetCtrl(itBdPtr, crBits);
+
+			XAxiDma_BdSetId(itBdPtr, txPtr); // assign arbitrary ID
+
+			itBdPtr = (XAxiDma_Bd*)XAxiDma_BdRingNext(txRingPtr, itBdPtr); assert(itBdPtr);
+			txPtr += thisBufNBytes;
+			nBytesRemaining -= thisBufNBytes;
+		}
+	}
+
+	// === submit to hardware ===
+	if (nBufsToQueue > 0){
+		s = XAxiDma_BdRingToHw(txRingPtr, nBufsToQueue, firstBdPtr); assert (s == XST_SUCCESS && "DMA queueTx: BdRingToHw() failed");
+		trace(dmaTrace::TRACE_TO_HW, /*isRx*/false, nBufsToQueue);
+	}
+}
+
+void dmaFeedPacket::queueRx(){
+	unsigned int nBufsToQueue = toArm.size();
+	if (!nBufsToQueue)
+		return;
+	assert((int)nBufsToQueue <= XAxiDma_BdRingGetFreeCnt(rxRingPtr)); // one BD per buffer
+
+	int s;
+	XAxiDma_Bd* firstBdPtr;
+	s = XAxiDma_BdRingAlloc(rxRingPtr, nBufsToQueue, &firstBdPtr); assert (s == XST_SUCCESS && "DMA queueRx: BdRingAlloc() failed");
+	XAxiDma_Bd* itBdPtr = firstBdPtr;
+
+	for (unsigned int ix = 0; ix < nBufsToQueue; ++ix){
+		unsigned int bufIx = 0;
+		bool ok = toArm.pop(bufIx); assert(ok); (void)ok;
+		char* data = bufferAddr(bufIx);
+
+		// no dirty lines may be evicted over DMA data
+		Xil_DCacheInvalidateRange((INTPTR)data, rxBufferSize);
+
+		s = XAxiDma_BdSetBufAddr(itBdPtr, (UINTPTR)data); assert (s == XST_SUCCESS && "DMA queueRx: BdSetBufAddr() failed");
+		s = XAxiDma_BdSetLength(itBdPtr, rxBufferSize, rxRingPtr->MaxTransferLen); assert (s == XST_SUCCESS && "DMA queueRx: BdSetLength() failed");
+		XAxiDma_BdSetCtrl(itBdPtr, 0); // unnecessary (HW will set)
+		XAxiDma_BdSetId(itBdPtr, bufIx); // identifies buffer on completion
+
+		itBdPtr = (XAxiDma_Bd*)XAxiDma_BdRingNext(rxRingPtr, itBdPtr); assert(itBdPtr);
+	}
+
+	s = XAxiDma_BdRingToHw(rxRingPtr, nBufsToQueue, firstBdPtr); assert (s == XST_SUCCESS && "DMA queueRx: BdRingToHw() failed");
+	trace(dmaTrace::TRACE_TO_HW, /*isRx*/true, nBufsToQueue);
+}
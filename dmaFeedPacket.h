@@ -0,0 +1,104 @@
+#ifndef DMAFEEDPACKET_H
+#define DMAFEEDPACKET_H
+#include "dmaFeedBase.h"
+#include "spscQueue.h"
+
+// all fields may be optionally configured before passing to dmaFeed constructor
+class dmaFeedPacketConfig: public dmaFeedBaseConfig{
+public:
+	dmaFeedPacketConfig(unsigned int dmaDevId, unsigned int txIntrId, unsigned int rxIntrId) : dmaFeedBaseConfig(dmaDevId, txIntrId, rxIntrId){
+	}
+	u32 maxPacketSize = 1 << 13; // bytes per Tx BD, up to configured width of DMA length register e.g. XPAR_AXI_DMA_0_SG_LENGTH_WIDTH
+	u32 nTxPackets = 64; // capacity of the Tx submission queue
+	u32 nRxBuffers = 32; // Rx buffer pool, one BD each (needs as many Rx BDs)
+	u32 rxBufferSize = 1 << 13; // bytes per Rx buffer. Multiple of the cache line size.
+};
+
+// AXI-Stream packets with guaranteed framing
+// - Tx: each sendPacket() is exactly one packet (TXSOF on its first BD, TXEOF => TLAST on its last), independent of how many
+//   BDs happen to be free. A packet must fit into the Tx BD ring.
+// - Rx: incoming packets are reassembled from the pool buffers they landed in (RXSOF .. RXEOF) and delivered with the actual
+//   lengths from the BD status words. A packet may span several buffers, up to all nRxBuffers.
+// Callbacks run in interrupt context (run_poll() in polling / deferred mode).
+class dmaFeedPacket: public dmaFeedBase{
+public:
+	// one piece of a received packet, in a pool buffer
+	typedef struct {
+		char* addr;
+		u32 nBytes;
+	} fragment_t;
+
+	// Tx packet with this tag was sent, its data may be reused
+	typedef void (*txDone_t)(void* context, void* tag);
+
+	// received packet of nBytes in nFrags fragments. Fragments are re-armed after return => consume or copy here
+	// truncated: packet ended on a DMA error status, or without RXSOF (head lost, e.g. after restart)
+	typedef void (*rxPacket_t)(void* context, const fragment_t* frags, unsigned int nFrags, u32 nBytes, bool truncated);
+
+	// pool: nRxBuffers * rxBufferSize bytes, cache line aligned, or NULL to allocate internally
+	dmaFeedPacket(const dmaFeedPacketConfig& config, char* pool = NULL);
+	~dmaFeedPacket();
+
+	// set before runStart()
+	void setTxDone(txDone_t txDone, void* context);
+	void setRxPacket(rxPacket_t rxPacket, void* context);
+
+	// arms all Rx buffers and starts Tx / Rx. Returns immediately; run_poll() stays DMAFEED_BUSY until runStop() or DMA error.
+	// Restarts a running instance (e.g. after DMAFEED_IDLE_ERROR); Tx packets not yet sent are dropped without txDone.
+	void runStart();
+
+	// stops and resets the DMA
+	void runStop();
+
+	// queues one Tx packet. Returns false if the submission queue is full. Data must stay valid until txDone.
+	// Do not call from a callback.
+	bool sendPacket(char* data, u32 nBytes, void* tag = NULL);
+private:
+	void collectTx() override final;
+	void collectRx() override final;
+	void queue(bool txFlag, bool rxFlag) override final;
+	void queueTx(); // splitting queue() in two for readability
+	void queueRx(); // arms released buffers
+
+	// need retval buffers to transmit given nr. bytes
+	unsigned int bytesToBufs(u32 nBytes) const;
+
+	char* bufferAddr(unsigned int bufIx) const {return pool + bufIx * rxBufferSize;}
+
+	typedef struct {
+		char* data;
+		u32 nBytes;
+		void* tag;
+	} txPacket_t;
+
+	// application => interrupt
+	spscQueue<txPacket_t> txSubmitted;
+
+	// tags of packets in hardware, in order (BD ID is only 32 bits wide)
+	spscQueue<void*> txTags;
+
+	// Rx buffers waiting to be armed
+	spscQueue<unsigned int> toArm;
+
+	// fragments of the packet being reassembled (nRxBuffers)
+	fragment_t* const frags;
+	unsigned int nFrags = 0;
+	u32 nPacketBytes = 0;
+	bool packetTruncated = false;
+
+	txDone_t txDone = NULL;
+	void* txDoneContext = NULL;
+	rxPacket_t rxPacket = NULL;
+	void* rxPacketContext = NULL;
+
+	char* pool;
+	// pool was allocated by the constructor
+	bool poolIsOwned = false;
+	const u32 nRxBuffers;
+	const u32 rxBufferSize;
+	const u32 maxPacketSize;
+
+	// between runStart() and runStop()
+	bool running = false;
+};
+#endif
@@ -0,0 +1,223 @@
+#include "dmaFeedPipe.h"
+
+namespace {
+// base configuration: rings of exactly one BD per buffer, none for an unused channel
+dmaFeedBaseConfig pipeBaseConfig(const dmaFeedPipeConfig& config){
+	dmaFeedBaseConfig c = config;
+	c.nBytesAllocTxBd = config.nTxBuffers * XAXIDMA_BD_MINIMUM_ALIGNMENT;
+	c.nBytesAllocRxBd = config.nRxBuffers * XAXIDMA_BD_MINIMUM_ALIGNMENT;
+	return c;
+}
+} // namespace
+
+dmaFeedPipe::dmaFeedPipe(const dmaFeedPipeConfig& config, char* pool) : dmaFeedStatic(pipeBaseConfig(config)),
+	pool(pool), nTxBuffers(config.useTx ? config.nTxBuffers : 0), nRxBuffers(config.useRx ? config.nRxBuffers : 0), bufferSize(config.bufferSize){
+	assert((config.nRxChannels == 1) && "multichannel Rx needs dmaFeedStream");
+	assert((!config.useTx || nTxBuffers) && (!config.useRx || nRxBuffers) && bufferSize);
+	assert((!config.useTx || (bufferSize <= txRingPtr->MaxTransferLen)) && (!config.useRx || (bufferSize <= rxRingPtr->MaxTransferLen)) && "bufferSize exceeds DMA length register");
+	assert(!(bufferSize % DMAFEED_CACHE_LINE) && "bufferSize must be a multiple of DMAFEED_CACHE_LINE"); // buffers share no cache line
+	if (!this->pool){
+		// stride == bufferSize (whole cache lines) => Tx buffers, then Rx buffers, as in a pool from the application
+		ownedPool = new dmaBufferPool(bufferSize, nTxBuffers + nRxBuffers);
+		this->pool = ownedPool->getBuffer(0);
+	}
+}
+
+dmaFeedPipe::~dmaFeedPipe(){
+	// DMA must not access the pool after it is freed
+	if (started && !doneFlag)
+		abort();
+	delete ownedPool;
+}
+
+void dmaFeedPipe::setProducer(producer_t producer, void* context){
+	this->producer = producer;
+	producerContext = context;
+}
+
+void dmaFeedPipe::setConsumer(consumer_t consumer, void* context){
+	this->consumer = consumer;
+	consumerContext = context;
+}
+
+void dmaFeedPipe::runStart(u32 numTxBytes, u32 numRxBytes){
+	assert((nTxBuffers || !numTxBytes) && (nRxBuffers || !numRxBytes) && "data for an unused channel");
+	assert((numTxBytes || numRxBytes) && "empty transaction");
+	assert((producer || !numTxBytes) && "Tx needs a producer");
+	// all buffers are free: BDs completed, or discarded with the rings rebuilt after an error
+	txBufIx = 0;
+	rxBufIx = 0;
+	nTxBytesRemainingToQueue = numTxBytes;
+	nTxBytesRemainingToComplete = numTxBytes;
+	nRxBytesTotal = numRxBytes;
+	nRxBytesReceived = 0;
+	nRxBytesArmed = 0;
+	// a channel without data (unused) is done from the start
+	txDone = !numTxBytes;
+	rxDone = !numRxBytes;
+	started = true;
+
+	dmaFeedBase::runStart();
+}
+
+void dmaFeedPipe::collectTx()/*override*/{
+	// === get completed BDs ===
+	XAxiDma_Bd *firstBdPtr; // first buffer descriptor in returned set
+	int nBd = XAxiDma_BdRingFromHw(txRingPtr, /*no limit to the number of returned BDs*/XAXIDMA_ALL_BDS, &firstBdPtr);
+	XAxiDma_Bd *itBdPtr = firstBdPtr;
+	if (nBd)
+		trace(dmaTrace::TRACE_FROM_HW, /*isRx*/false, nBd);
+
+	// === count transmitted bytes ===
+	u32 numNewBytesTransmitted = 0;
+	int bdCount = nBd;
+	while (bdCount--){
+		u32 bdStatus = XAxiDma_BdGetSts(itBdPtr);
+		assert(!(bdStatus & XAXIDMA_BD_STS_ALL_ERR_MASK));
+		assert(bdStatus & XAXIDMA_BD_STS_COMPLETE_MASK);
+		numNewBytesTransmitted += XAxiDma_BdGetLength(itBdPtr, txRingPtr->MaxTransferLen);
+		itBdPtr = (XAxiDma_Bd *)XAxiDma_BdRingNext(txRingPtr, itBdPtr);
+	}
+	statsBytes(/*isRx*/false, numNewBytesTransmitted);
+
+	// === return completed BDs to pool (their buffers are free again, queueTx() refills them) ===
+	int s = XAxiDma_BdRingFree(txRingPtr, nBd, firstBdPtr); assert(s == XST_SUCCESS && "XAxiDma_BdRingFree(Tx) failed");
+
+	// === detect end of transmission ===
+	assert(numNewBytesTransmitted <= nTxBytesRemainingToComplete);
+	nTxBytesRemainingToComplete -= numNewBytesTransmitted;
+	if (!nTxBytesRemainingToComplete && !txDone){
+		txDone = true;
+		if (txDone && rxDone)
+			done();
+	}
+}
+
+void dmaFeedPipe::collectRx()/*override*/{
+	// === get completed BDs ===
+	XAxiDma_Bd *firstBdPtr; // first buffer descriptor in returned set
+	int nBd = XAxiDma_BdRingFromHw(rxRingPtr, /*no limit to the number of returned BDs*/XAXIDMA_ALL_BDS, &firstBdPtr);
+	XAxiDma_Bd *itBdPtr = firstBdPtr;
+	if (nBd)
+		trace(dmaTrace::TRACE_FROM_HW, /*isRx*/true, nBd);
+
+	// === hand each buffer to the consumer, in order ===
+	int bdCount = nBd;
+	while (bdCount--){
+		u32 bdStatus = XAxiDma_BdGetSts(itBdPtr);
+		assert(!(bdStatus & XAXIDMA_BD_STS_ALL_ERR_MASK));
+		assert(bdStatus & XAXIDMA_BD_STS_COMPLETE_MASK);
+		char* data = rxBufferAddr(XAxiDma_BdGetId(itBdPtr));
+		u32 nActual = XAxiDma_BdGetActualLength(itBdPtr, rxRingPtr->MaxTransferLen);
+
+		// lines may have been speculatively fetched while the DMA wrote the buffer
+		cacheInvalidate(data, nActual);
+		statsBytes(/*isRx*/true, nActual);
+		if (consumer)
+			consumer(consumerContext, data, nActual);
+
+		nRxBytesArmed -= XAxiDma_BdGetLength(itBdPtr, rxRingPtr->MaxTransferLen);
+		nRxBytesReceived += nActual;
+		itBdPtr = (XAxiDma_Bd *)XAxiDma_BdRingNext(rxRingPtr, itBdPtr);
+	}
+
+	// === return completed BDs to pool (the consumer is done with their buffers, queueRx() re-arms them) ===
+	int s = XAxiDma_BdRingFree(rxRingPtr, nBd, firstBdPtr); assert(s == XST_SUCCESS && "XAxiDma_BdRingFree(Rx) failed");
+
+	// === detect end of reception ===
+	// armed capacity never exceeds what is left => nothing armed any more
+	assert(nRxBytesReceived <= nRxBytesTotal);
+	if ((nRxBytesReceived == nRxBytesTotal) && !rxDone){
+		rxDone = true;
+		if (txDone && rxDone)
+			done();
+	}
+}
+
+void dmaFeedPipe::queue(bool txEvent, bool rxEvent)/*override*/{
+	if (txEvent)
+		queueTx();
+	if (rxEvent)
+		queueRx();
+}
+
+void dmaFeedPipe::queueTx(){
+	// one BD per buffer => free BDs are free buffers
+	u32 nFreeBd = XAxiDma_BdRingGetFreeCnt(txRingPtr);
+	u32 nBufsToQueue = (nTxBytesRemainingToQueue + bufferSize - 1) / bufferSize;
+	if (nBufsToQueue > nFreeBd)
+		nBufsToQueue = nFreeBd;
+	if (!nBufsToQueue)
+		return;
+
+	int s;
+	XAxiDma_Bd* firstBdPtr;
+	s = XAxiDma_BdRingAlloc(txRingPtr, nBufsToQueue, &firstBdPtr); assert (s == XST_SUCCESS && "DMA queueTx: BdRingAlloc() failed");
+	XAxiDma_Bd* itBdPtr = firstBdPtr;
+
+	for (u32 ix = 0; ix < nBufsToQueue; ++ix){
+		u32 n = (nTxBytesRemainingToQueue < bufferSize) ? nTxBytesRemainingToQueue : bufferSize;
+		char* data = txBufferAddr(txBufIx);
+
+		// just in time: the buffer's previous BD has completed
+		producer(producerContext, data, n);
+		// DMA doesn't go through cache => must flush
+		cacheFlush(data, n);
+
+		// === flag first and last BD of this packet ===
+		u32 crBits = 0;
+		if (!ix)
+			crBits |= XAXIDMA_BD_CTRL_TXSOF_MASK;
+		if (ix == nBufsToQueue - 1)
+			crBits |= XAXIDMA_BD_CTRL_TXEOF_MASK;
+
+		s = XAxiDma_BdSetBufAddr(itBdPtr, (UINTPTR)data); assert(s == XST_SUCCESS && "DMA queueTx: BdSetBufAddr() failed");
+		s = XAxiDma_BdSetLength(itBdPtr, n, txRingPtr->MaxTransferLen); assert(s == XST_SUCCESS && "DMA queueTx: BdSetLength() failed");
+		XAxiDma_BdSetCtrl(itBdPtr, crBits);
+		XAxiDma_BdSetId(itBdPtr, txBufIx);
+
+		txBufIx = (txBufIx + 1) % nTxBuffers;
+		nTxBytesRemainingToQueue -= n;
+		itBdPtr = (XAxiDma_Bd*)XAxiDma_BdRingNext(txRingPtr, itBdPtr); assert(itBdPtr);
+	}
+
+	s = XAxiDma_BdRingToHw(txRingPtr, nBufsToQueue, firstBdPtr); assert (s == XST_SUCCESS && "DMA queueTx: BdRingToHw() failed");
+	trace(dmaTrace::TRACE_TO_HW, /*isRx*/false, nBufsToQueue);
+}
+
+void dmaFeedPipe::queueRx(){
+	// one BD per buffer => free BDs are free buffers. Arm no more than the rest of the transaction can fill
+	u32 nFreeBd = XAxiDma_BdRingGetFreeCnt(rxRingPtr);
+	u32 nBytesUncovered = nRxBytesTotal - nRxBytesReceived - nRxBytesArmed;
+	u32 nBufsToQueue = (nBytesUncovered + bufferSize - 1) / bufferSize;
+	if (nBufsToQueue > nFreeBd)
+		nBufsToQueue = nFreeBd;
+	if (!nBufsToQueue)
+		return;
+
+	int s;
+	XAxiDma_Bd* firstBdPtr;
+	s = XAxiDma_BdRingAlloc(rxRingPtr, nBufsToQueue, &firstBdPtr); assert (s == XST_SUCCESS && "DMA queueRx: BdRingAlloc() failed");
+	XAxiDma_Bd* itBdPtr = firstBdPtr;
+
+	for (u32 ix = 0; ix < nBufsToQueue; ++ix){
+		u32 n = (nBytesUncovered < bufferSize) ? nBytesUncovered : bufferSize;
+		char* data = rxBufferAddr(rxBufIx);
+
+		// no dirty lines may be evicted over DMA data (the consumer only read the buffer)
+		cacheInvalidate(data, n);
+
+		s = XAxiDma_BdSetBufAddr(itBdPtr, (UINTPTR)data); assert (s == XST_SUCCESS && "DMA queueRx: BdSetBufAddr() failed");
+		s = XAxiDma_BdSetLength(itBdPtr, n, rxRingPtr->MaxTransferLen); assert (s == XST_SUCCESS && "DMA queueRx: BdSetLength() failed");
+		XAxiDma_BdSetCtrl(itBdPtr, 0); // unnecessary (HW will set)
+		XAxiDma_BdSetId(itBdPtr, rxBufIx); // identifies buffer on completion
+
+		rxBufIx = (rxBufIx + 1) % nRxBuffers;
+		nBytesUncovered -= n;
+		nRxBytesArmed += n;
+		itBdPtr = (XAxiDma_Bd*)XAxiDma_BdRingNext(rxRingPtr, itBdPtr); assert(itBdPtr);
+	}
+
+	s = XAxiDma_BdRingToHw(rxRingPtr, nBufsToQueue, firstBdPtr); assert (s == XST_SUCCESS && "DMA queueRx: BdRingToHw() failed");
+	trace(dmaTrace::TRACE_TO_HW, /*isRx*/true, nBufsToQueue);
+}
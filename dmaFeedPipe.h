@@ -0,0 +1,89 @@
+#ifndef DMAFEEDPIPE_H
+#define DMAFEEDPIPE_H
+#include "dmaFeedStatic.h"
+#include "dmaBufferPool.h"
+
+// all fields may be optionally configured before passing to dmaFeed constructor
+class dmaFeedPipeConfig: public dmaFeedBaseConfig{
+public:
+	dmaFeedPipeConfig(unsigned int dmaDevId, unsigned int txIntrId, unsigned int rxIntrId) : dmaFeedBaseConfig(dmaDevId, txIntrId, rxIntrId){
+	}
+	// Tx buffers, one BD each (the Tx ring is sized to exactly nTxBuffers, nBytesAllocTxBd is ignored). The producer fills them
+	// at most this far ahead of the DMA. A Tx packet (TLAST) ends with the last buffer of each queue() call
+	u32 nTxBuffers = 16;
+	// Rx buffers, one BD each (the Rx ring is sized to exactly nRxBuffers, nBytesAllocRxBd is ignored). The driver returns Rx BDs
+	// per packet => an incoming packet (TLAST) must fit into nRxBuffers * bufferSize. With a loopback at least nTxBuffers
+	u32 nRxBuffers = 16;
+	// size of one Tx / Rx buffer in bytes. Up to configured width of DMA length register. Multiple of the cache line size.
+	u32 bufferSize = 1 << 13;
+};
+
+// sends and receives a predetermined amount of data through small rings of reused buffers, without holding it in memory
+// - Tx: queue() pulls each chunk from the producer callback into the next free Tx buffer just before handing its BD to the DMA
+// - Rx: collectRx() passes each filled Rx buffer to the consumer callback and re-arms it after the callback returns
+// Memory: (nTxBuffers + nRxBuffers) * bufferSize bytes and as many BDs, whatever the transaction size. Chunks are bufferSize
+// bytes except the last one, in stream order on each side. Rx chunks end early at TLAST (actual length from the BD status).
+// The callbacks run in interrupt context with DMAFEED_COMPLETION_IRQ, in run_poll() with the polling and deferred modes (e.g.
+// for a producer that computes its data). Tx only / Rx only: see dmaFeedBaseConfig::useTx / useRx.
+class dmaFeedPipe: public dmaFeedStatic<dmaFeedPipe>{
+public:
+	// fills data with the next nBytes of the Tx stream
+	typedef void (*producer_t)(void* context, char* data, u32 nBytes);
+	// processes the next nBytes of the Rx stream. data is re-armed for the DMA after the callback returns
+	typedef void (*consumer_t)(void* context, const char* data, u32 nBytes);
+
+	// pool: (nTxBuffers + nRxBuffers) * bufferSize bytes (without the unused channel), cache line aligned, or NULL to allocate
+	// internally (dmaBufferPool). bufferSize: a multiple of DMAFEED_CACHE_LINE
+	dmaFeedPipe(const dmaFeedPipeConfig& config, char* pool = NULL);
+	~dmaFeedPipe();
+
+	// set before runStart(). No consumer: Rx data is dropped
+	void setProducer(producer_t producer, void* context);
+	void setConsumer(consumer_t consumer, void* context);
+
+	// starts a transaction of numTxBytes from the producer and numRxBytes to the consumer (0: channel unused)
+	void runStart(u32 numTxBytes, u32 numRxBytes);
+
+	// received bytes of the current / last transaction (actual lengths from BD status)
+	u32 getRxBytesReceived() const {return nRxBytesReceived;}
+private:
+	friend class dmaFeedStatic<dmaFeedPipe>;
+	void collectTx() override final;
+	void collectRx() override final;
+	void queue(bool txFlag, bool rxFlag) override final;
+	void queueTx(); // fills and queues free Tx buffers
+	void queueRx(); // arms free Rx buffers
+
+	char* txBufferAddr(unsigned int bufIx) const {return pool + bufIx * bufferSize;}
+	char* rxBufferAddr(unsigned int bufIx) const {return pool + (nTxBuffers + bufIx) * bufferSize;}
+
+	producer_t producer = NULL;
+	void* producerContext = NULL;
+	consumer_t consumer = NULL;
+	void* consumerContext = NULL;
+
+	char* pool;
+	// pool allocated by the constructor, NULL if from the application
+	dmaBufferPool* ownedPool = NULL;
+	const u32 nTxBuffers; // 0: Tx unused
+	const u32 nRxBuffers; // 0: Rx unused
+	const u32 bufferSize;
+
+	// buffer of the next BD to queue. The rings hold exactly one BD per buffer and BDs are allocated in ring order => a free BD
+	// always comes with a free buffer
+	unsigned int txBufIx = 0;
+	unsigned int rxBufIx = 0;
+
+	// Tx: handed to the DMA / not yet completed
+	u32 nTxBytesRemainingToQueue = 0;
+	u32 nTxBytesRemainingToComplete = 0;
+	// Rx: expected in total, received, capacity of the armed buffers (short packets leave room for more buffers)
+	u32 nRxBytesTotal = 0;
+	u32 nRxBytesReceived = 0;
+	u32 nRxBytesArmed = 0;
+	bool txDone = false;
+	bool rxDone = false;
+	// a transaction was started (DMA may own buffers of the pool)
+	bool started = false;
+};
+#endif
@@ -0,0 +1,62 @@
+#ifndef DMAFEEDSTATIC_H
+#define DMAFEEDSTATIC_H
+#include "dmaFeedBaseIsr.h"
+
+// compile with -DDMAFEED_COHERENT=1 if DMA data buffers are IO coherent: dmaFeedStatic classes then skip cache maintenance
+// (default of dmaFeedPolicy::cacheMaintenance)
+#ifndef DMAFEED_COHERENT
+#	define DMAFEED_COHERENT 0
+#endif
+
+// compile-time options of dmaFeedStatic
+// - hasTx / hasRx: the derived class uses the channel. Without, its interrupt callback only acknowledges and checks for errors,
+//   and the derived class' collectTx() / collectRx() stay out of the interrupt path
+// - stats: statistics in the interrupt callbacks (default DMAFEED_STATS; getStats() fields of run_poll() and runStart() follow DMAFEED_STATS)
+// - cacheMaintenance: for the derived class: flush / invalidate data buffers (cacheFlush() / cacheInvalidate()). false for IO
+//   coherent buffers (e.g. ZynqMP HPC ports with coherent AXI transactions) compiles the cache calls out
+template<bool hasTxT = true, bool hasRxT = true, bool statsT = DMAFEED_STATS, bool cacheMaintenanceT = !DMAFEED_COHERENT>
+struct dmaFeedPolicy{
+	static constexpr bool hasTx = hasTxT;
+	static constexpr bool hasRx = hasRxT;
+	static constexpr bool stats = statsT;
+	static constexpr bool cacheMaintenance = cacheMaintenanceT;
+};
+
+// CRTP variant of dmaFeedBase (derived_t derives from dmaFeedStatic<derived_t, policy_t>): the interrupt callbacks call
+// derived_t::collectTx() / collectRx() / queue() directly instead of through the vtable. Instantiated with the derived class,
+// in the translation unit that defines them => the compiler generates interrupt callbacks specialized per class and policy,
+// with the per-BD loops inlined.
+// - the derived class overrides the dmaFeedBase virtuals as usual (run_poll() and runStart() still call through the vtable)
+//   and grants access with "friend class dmaFeedStatic<derived_t, policy_t>;" if they are private
+// - only the interrupt path is specialized: polling and deferred modes behave as with dmaFeedBase
+template<class derived_t, class policy_t = dmaFeedPolicy<>>
+class dmaFeedStatic: public dmaFeedBase{
+public:
+	typedef policy_t policy;
+protected:
+	// inlineIsr false: connect the vtable callbacks of dmaFeedBase instead (reference, see benchmark)
+	dmaFeedStatic(const dmaFeedBaseConfig& config, bool inlineIsr = true) : dmaFeedBase(config){
+		if (!inlineIsr)
+			return;
+		txCallback = (Xil_InterruptHandler)txInterruptCallback<staticDispatch>;
+		rxCallback = (Xil_InterruptHandler)rxInterruptCallback<staticDispatch>;
+	}
+
+	// cache maintenance of data buffers, compiled out without policy_t::cacheMaintenance
+	static void cacheFlush(const void* addr, u32 nBytes){
+		if (policy_t::cacheMaintenance)
+			Xil_DCacheFlushRange((INTPTR)addr, nBytes);
+	}
+	static void cacheInvalidate(const void* addr, u32 nBytes){
+		if (policy_t::cacheMaintenance)
+			Xil_DCacheInvalidateRange((INTPTR)addr, nBytes);
+	}
+private:
+	// qualified calls: no virtual dispatch
+	struct staticDispatch: policy_t{
+		static void collectTx(dmaFeedBase* self){static_cast<derived_t*>(self)->derived_t::collectTx();}
+		static void collectRx(dmaFeedBase* self){static_cast<derived_t*>(self)->derived_t::collectRx();}
+		static void queue(dmaFeedBase* self, bool txEvent, bool rxEvent){static_cast<derived_t*>(self)->derived_t::queue(txEvent, rxEvent);}
+	};
+};
+#endif
@@ -0,0 +1,157 @@
+#include "dmaFeedStream.h"
+#include <cstdlib>
+
+dmaFeedStream::dmaFeedStream(const dmaFeedStreamConfig& config, char* pool) : dmaFeedStatic(config),
+	filled(config.nRxChannels * config.nBuffers), pool(pool), nChannels(config.nRxChannels), nBuffers(config.nBuffers), bufferSize(config.bufferSize){
+	assert(nBuffers && bufferSize);
+	assert(!config.useTx && config.useRx && "dmaFeedStream is Rx only");
+	assert(bufferSize <= rxRingPtr->MaxTransferLen && "bufferSize exceeds DMA length register");
+	assert((u32)XAxiDma_BdRingGetCnt(rxRingPtr) >= nBuffers && "need one Rx BD per buffer, increase nBytesAllocRxBd");
+	for (unsigned int ch = 0; ch < nChannels; ++ch)
+		toArm[ch] = new spscQueue<unsigned int>(nBuffers);
+	if (!this->pool){
+		this->pool = (char*)aligned_alloc(XAXIDMA_BD_MINIMUM_ALIGNMENT, nChannels * nBuffers * bufferSize);
+		assert(this->pool && "aligned_alloc failed");
+		poolIsOwned = true;
+	}
+}
+
+dmaFeedStream::~dmaFeedStream(){
+	// DMA must not write into the pool after it is freed
+	runStop();
+	if (poolIsOwned)
+		free(pool);
+	for (unsigned int ch = 0; ch < nChannels; ++ch)
+		delete toArm[ch];
+}
+
+void dmaFeedStream::setConsumer(consumer_t consumer, void* context, unsigned int channel){
+	assert(!running);
+	assert(channel < nChannels);
+	this->consumer[channel] = consumer;
+	consumerContext[channel] = context;
+}
+
+void dmaFeedStream::runStart(){
+	runStop(); // e.g. restart after DMA error
+	filled.clear();
+	for (unsigned int ch = 0; ch < nChannels; ++ch){
+		toArm[ch]->clear();
+		for (unsigned int ix = 0; ix < nBuffers; ++ix)
+			toArm[ch]->push(ch * nBuffers + ix);
+	}
+	running = true;
+	dmaFeedBase::runStart();
+}
+
+void dmaFeedStream::runStop(){
+	if (!running)
+		return;
+	abort();
+	running = false;
+}
+
+bool dmaFeedStream::getFilled(unsigned int& bufIx, char*& data, u32& nBytes, bool& eop){
+	filled_t f;
+	if (!filled.pop(f))
+		return false;
+	bufIx = f.bufIx;
+	data = bufferAddr(f.bufIx);
+	nBytes = f.nBytes;
+	eop = f.eop;
+	return true;
+}
+
+void dmaFeedStream::release(unsigned int bufIx){
+	assert(bufIx < nChannels * nBuffers);
+	unsigned int ch = bufferChannel(bufIx);
+	// queueRx() also runs from the Rx interrupt
+	Xil_ExceptionDisable();
+	toArm[ch]->push(bufIx);
+	if (running && !doneFlag)
+		queueRx(ch); // all buffers may have been held => no interrupt would re-arm
+	Xil_ExceptionEnable();
+}
+
+void dmaFeedStream::collectTx()/*override*/{
+	// Tx unused
+}
+
+void dmaFeedStream::collectRx()/*override*/{
+	// one interrupt for all channels
+	for (unsigned int ch = 0; ch < nChannels; ++ch){
+		XAxiDma_BdRing* ringPtr = getRxRing(ch);
+		XAxiDma_Bd *firstBdPtr; // first buffer descriptor in returned set
+		int nBd = XAxiDma_BdRingFromHw(ringPtr, /*no limit to the number of returned BDs*/XAXIDMA_ALL_BDS, &firstBdPtr);
+		if (nBd)
+			trace(dmaTrace::TRACE_FROM_HW, /*isRx*/true, nBd);
+		XAxiDma_Bd *itBdPtr = firstBdPtr;
+
+		int bdCount = nBd;
+		while (bdCount--){
+			u32 bdStatus = XAxiDma_BdGetSts(itBdPtr);
+			assert(!(bdStatus & XAXIDMA_BD_STS_ALL_ERR_MASK));
+			assert(bdStatus & XAXIDMA_BD_STS_COMPLETE_MASK);
+			filled_t f;
+			f.bufIx = XAxiDma_BdGetId(itBdPtr);
+			f.nBytes = XAxiDma_BdGetActualLength(itBdPtr, ringPtr->MaxTransferLen);
+			f.eop = bdStatus & XAXIDMA_BD_STS_RXEOF_MASK;
+			itBdPtr = (XAxiDma_Bd *)XAxiDma_BdRingNext(ringPtr, itBdPtr);
+
+			// lines may have been speculatively fetched while the DMA wrote the buffer
+			char* data = bufferAddr(f.bufIx);
+			cacheInvalidate(data, f.nBytes);
+			statsBytes(/*isRx*/true, f.nBytes);
+
+			if (consumer[ch]){
+				if (consumer[ch](consumerContext[ch], f.bufIx, data, f.nBytes, f.eop))
+					toArm[ch]->push(f.bufIx);
+			} else {
+				bool s = filled.push(f); assert(s && "dmaFeedStream: filled queue overflow"); (void)s; // holds all buffers => cannot overflow
+			}
+		}
+
+		// === return completed BDs to pool (buffers are tracked separately) ===
+		int s = XAxiDma_BdRingFree(ringPtr, nBd, firstBdPtr); assert(s == XST_SUCCESS && "XAxiDma_BdRingFree(Rx) failed");
+	}
+}
+
+void dmaFeedStream::queue(bool txEvent, bool rxEvent)/*override*/{
+	(void)txEvent; // Tx unused
+	if (rxEvent)
+		for (unsigned int ch = 0; ch < nChannels; ++ch)
+			queueRx(ch);
+}
+
+void dmaFeedStream::queueRx(unsigned int channel){
+	XAxiDma_BdRing* ringPtr = getRxRing(channel);
+	spscQueue<unsigned int>& q = *toArm[channel];
+	unsigned int nBufsToQueue = q.size();
+	if (!nBufsToQueue)
+		return;
+	assert((int)nBufsToQueue <= XAxiDma_BdRingGetFreeCnt(ringPtr)); // one BD per buffer
+
+	int s;
+	XAxiDma_Bd* firstBdPtr;
+	s = XAxiDma_BdRingAlloc(ringPtr, nBufsToQueue, &firstBdPtr); assert (s == XST_SUCCESS && "DMA queueRx: BdRingAlloc() failed");
+	XAxiDma_Bd* itBdPtr = firstBdPtr;
+
+	for (unsigned int ix = 0; ix < nBufsToQueue; ++ix){
+		unsigned int bufIx = 0;
+		bool ok = q.pop(bufIx); assert(ok); (void)ok;
+		char* data = bufferAddr(bufIx);
+
+		// no dirty lines may be evicted over DMA data
+		cacheInvalidate(data, bufferSize);
+
+		s = XAxiDma_BdSetBufAddr(itBdPtr, (UINTPTR)data); assert (s == XST_SUCCESS && "DMA queueRx: BdSetBufAddr() failed");
+		s = XAxiDma_BdSetLength(itBdPtr, bufferSize, ringPtr->MaxTransferLen); assert (s == XST_SUCCESS && "DMA queueRx: BdSetLength() failed");
+		XAxiDma_BdSetCtrl(itBdPtr, 0); // unnecessary (HW will set)
+		XAxiDma_BdSetId(itBdPtr, bufIx); // identifies buffer on completion
+
+		itBdPtr = (XAxiDma_Bd*)XAxiDma_BdRingNext(ringPtr, itBdPtr); assert(itBdPtr);
+	}
+
+	s = XAxiDma_BdRingToHw(ringPtr, nBufsToQueue, firstBdPtr); assert (s == XST_SUCCESS && "DMA queueRx: BdRingToHw() failed");
+	trace(dmaTrace::TRACE_TO_HW, /*isRx*/true, nBufsToQueue);
+}
@@ -0,0 +1,93 @@
+#ifndef DMAFEEDSTREAM_H
+#define DMAFEEDSTREAM_H
+#include "dmaFeedStatic.h"
+#include "spscQueue.h"
+
+// all fields may be optionally configured before passing to dmaFeed constructor
+class dmaFeedStreamConfig: public dmaFeedBaseConfig{
+public:
+	dmaFeedStreamConfig(unsigned int dmaDevId, unsigned int txIntrId, unsigned int rxIntrId) : dmaFeedBaseConfig(dmaDevId, txIntrId, rxIntrId){
+		useTx = false; // Rx only
+	}
+	// number of Rx buffers in the pool, per Rx channel (needs as many Rx BDs)
+	u32 nBuffers = 16;
+	// size of one Rx buffer in bytes, one BD each. Up to configured width of DMA length register. Multiple of the cache line size.
+	u32 bufferSize = 1 << 13;
+};
+
+// endless S2MM reception into a pool of recycled buffers
+// - all buffers not held by the application stay armed; rings and interrupts stay up between buffers
+// - each filled buffer goes to the consumer callback (interrupt context) or, without callback, to a queue read by getFilled()
+// - the application returns a buffer with release(), which re-arms it
+// Note: the DMA driver returns BDs at packet (TLAST) granularity. The stream source must assert TLAST at least once per
+// nBuffers * bufferSize bytes, otherwise reception stalls with all buffers filled.
+// With DMAFEED_COMPLETION_POLL / _HYBRID / _DEFERRED, the application must call run_poll() to make progress; the consumer then runs in run_poll().
+// The Tx channel is unused (no ring, no interrupt, see dmaFeedBaseConfig::useTx).
+// Multichannel DMA (nRxChannels > 1): each channel (TDEST) has its own nBuffers buffers and consumer. Buffer indices run over
+// all channels, channel c owns c * nBuffers .. (c + 1) * nBuffers - 1 (see bufferChannel()).
+// A packet for a channel without armed buffers blocks the S2MM stream for all channels.
+// Interrupt callbacks are specialized for this class (dmaFeedStatic, Rx only).
+class dmaFeedStream: public dmaFeedStatic<dmaFeedStream, dmaFeedPolicy</*hasTx*/false>>{
+public:
+	// called in interrupt context for each filled buffer
+	// - bufIx: index in the pool, data: start of buffer, nBytes: received length from BD status, eop: buffer ends a packet (TLAST)
+	// - return true to release (re-arm) the buffer immediately, false to keep it until release()
+	typedef bool (*consumer_t)(void* context, unsigned int bufIx, char* data, u32 nBytes, bool eop);
+
+	// pool: nRxChannels * nBuffers * bufferSize bytes, cache line aligned, or NULL to allocate internally
+	dmaFeedStream(const dmaFeedStreamConfig& config, char* pool = NULL);
+	~dmaFeedStream();
+
+	// filled buffers of the Rx channel go to consumer instead of the getFilled() queue. Set before runStart()
+	void setConsumer(consumer_t consumer, void* context, unsigned int channel = 0);
+
+	// arms all buffers and starts reception. Returns immediately; run_poll() stays DMAFEED_BUSY until runStop() or DMA error.
+	// Buffers held by the application are implicitly released. Restarts a running stream (e.g. after DMAFEED_IDLE_ERROR).
+	void runStart();
+
+	// stops reception and resets the DMA. Buffers in flight are discarded
+	void runStop();
+
+	// next filled buffer, if any (queue mode). Returns false if none
+	bool getFilled(unsigned int& bufIx, char*& data, u32& nBytes, bool& eop);
+
+	// returns a buffer obtained from getFilled() or kept by the consumer to the pool. Do not call from the consumer callback.
+	void release(unsigned int bufIx);
+
+	char* bufferAddr(unsigned int bufIx) const {return pool + bufIx * bufferSize;}
+
+	// Rx channel (TDEST) a buffer belongs to
+	unsigned int bufferChannel(unsigned int bufIx) const {return bufIx / nBuffers;}
+private:
+	friend class dmaFeedStatic<dmaFeedStream, dmaFeedPolicy</*hasTx*/false>>;
+	void collectTx() override final;
+	void collectRx() override final;
+	void queue(bool txFlag, bool rxFlag) override final;
+	void queueRx(unsigned int channel); // arms released buffers
+
+	typedef struct {
+		unsigned int bufIx;
+		u32 nBytes;
+		bool eop;
+	} filled_t;
+
+	// buffers with data, waiting for getFilled() (interrupt => application)
+	spscQueue<filled_t> filled;
+
+	// buffers waiting to be armed, per channel
+	spscQueue<unsigned int>* toArm[XAXIDMA_MAX_NUM_CHANNELS] = {};
+
+	consumer_t consumer[XAXIDMA_MAX_NUM_CHANNELS] = {};
+	void* consumerContext[XAXIDMA_MAX_NUM_CHANNELS] = {};
+
+	char* pool;
+	// pool was allocated by the constructor
+	bool poolIsOwned = false;
+	const unsigned int nChannels;
+	const u32 nBuffers;
+	const u32 bufferSize;
+
+	// reception is active (between runStart() and runStop() / error)
+	bool running = false;
+};
+#endif
@@ -0,0 +1,62 @@
+#include "dmaServiceCore.h"
+
+dmaServiceCore::dmaServiceCore(dmaFeedJobs& jobs, unsigned int nRequests) : jobs(jobs),
+	requests(nRequests), completions(nRequests), tickets(new ticket_t[nRequests]), nTickets(nRequests){
+	assert(nTickets);
+}
+
+dmaServiceCore::~dmaServiceCore(){
+	delete[] tickets;
+}
+
+bool dmaServiceCore::submit(const request_t& request){
+	assert((request.nTxBytes || request.nRxBytes) && "empty request");
+	return requests.push(request);
+}
+
+bool dmaServiceCore::getCompletion(completion_t& completion){
+	return completions.pop(completion);
+}
+
+void dmaServiceCore::jobDone(void* context, bool ok){
+	ticket_t* t = (ticket_t*)context;
+	bool s = t->self->completions.push({t->context, ok}); assert(s && "completion ring overflow"); (void)s;
+	t->self->nCompleted.fetch_add(1, std::memory_order_release);
+}
+
+bool dmaServiceCore::serviceOnce(){
+	bool progress = false;
+	unsigned int nCompletedBefore = nCompleted.load(std::memory_order_acquire);
+	request_t r;
+	while (true){
+		// forwarded, not yet consumed by the application: completed count before the ring size => an interrupt in between
+		// counts twice, never not at all. Below nTickets => the completion ring has room for every outstanding job
+		unsigned int nOutstanding = nForwarded - nCompleted.load(std::memory_order_acquire);
+		if (nOutstanding + completions.size() >= nTickets)
+			break;
+		if (!requests.peek(r))
+			break;
+		ticket_t& t = tickets[nForwarded % nTickets];
+		t.self = this;
+		t.context = r.context;
+		dmaFeedJobs::job_t job = {r.txBuf, r.nTxBytes, r.rxBuf, r.nRxBytes, jobDone, &t};
+		if (!jobs.submit(job))
+			break; // submission queue full, next pass
+		requests.pop(r);
+		++nForwarded;
+		progress = true;
+	}
+
+	if (jobs.run_poll() == dmaFeedBase::DMAFEED_IDLE_ERROR)
+		jobs.runStart(); // fails outstanding jobs (completions with ok false), continues with the next requests
+	return progress || (nCompleted.load(std::memory_order_acquire) != nCompletedBefore);
+}
+
+void dmaServiceCore::run(void (*idle)(void* context), void* context){
+	jobs.runStart();
+	while (!stopRequested.load(std::memory_order_acquire))
+		if (!serviceOnce() && idle)
+			idle(context);
+	jobs.runStop();
+	stopRequested.store(false, std::memory_order_relaxed);
+}
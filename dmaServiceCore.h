@@ -0,0 +1,85 @@
+#ifndef DMASERVICECORE_H
+#define DMASERVICECORE_H
+#include "dmaFeedJobs.h"
+#include "spscQueue.h"
+#include <atomic>
+
+// runs a dmaFeedJobs instance on a core of its own ("service core"), for an application core that only exchanges messages with it
+// - application core: submit() requests, getCompletion() their results. Both are lock-free spscQueue operations => no interrupt
+//   masking, no lock shared with the service core, and the DMA interrupts never preempt the application's processing
+// - service core: constructs the dmaFeedJobs instance and calls run(), which starts it (interrupts are connected there, see
+//   dmaFeedBaseConfig::irqCpu), forwards requests to dmaFeedJobs::submit(), services the DMA through run_poll() and posts
+//   each job callback as a completion. DMAFEED_COMPLETION_DEFERRED or _POLL keep all BD work in the run() loop
+// - exactly one application thread (single producer of requests, single consumer of completions)
+// The rings are ordinary cacheable memory, shared through the coherent caches of the Zynq / ZynqMP application cores. Cache
+// maintenance of the data buffers happens on the service core (flush in dmaFeedJobs::submit(), Rx invalidate as BDs complete)
+// and reaches the other core's lines the same way.
+class dmaServiceCore{
+public:
+	typedef struct {
+		char* txBuf;
+		u32 nTxBytes; // 0: Rx-only job
+		char* rxBuf;
+		u32 nRxBytes; // 0: Tx-only job
+		void* context; // returned with the completion
+	} request_t;
+
+	typedef struct {
+		void* context; // of the request
+		bool ok; // false: failed by a DMA error or by the end of run()
+	} completion_t;
+
+	// nRequests: capacity of the request ring, and most requests in flight between submit() and getCompletion()
+	dmaServiceCore(dmaFeedJobs& jobs, unsigned int nRequests);
+	~dmaServiceCore();
+	dmaServiceCore(const dmaServiceCore&) = delete;
+	dmaServiceCore& operator=(const dmaServiceCore&) = delete;
+
+	// === application core ===
+
+	// queues a request. Returns false if the ring is full. Buffers must stay valid until its completion
+	bool submit(const request_t& request);
+
+	// oldest completion, in submission order. Returns false if none yet
+	bool getCompletion(completion_t& completion);
+
+	// asks run() to return. Requests not yet forwarded stay queued for the next run()
+	void stop(){stopRequested.store(true, std::memory_order_release);}
+
+	// === service core ===
+
+	// until stop(): one serviceOnce() after the other. A pass without progress calls idle(context) if given (e.g. wait for
+	// event). Finally stops the jobs instance, outstanding jobs complete as failed
+	void run(void (*idle)(void* context) = NULL, void* context = NULL);
+
+	// one pass of run(), e.g. from an existing main loop (jobs instance started by the caller): forwards requests, calls
+	// run_poll() and restarts the jobs instance after a DMA error. Returns whether a request was forwarded or a job completed
+	bool serviceOnce();
+private:
+	// job callback (service core: interrupt or run_poll()), posts the completion
+	static void jobDone(void* context, bool ok);
+
+	// dmaFeedJobs callback context of a forwarded request. Reused round-robin: jobs complete in order, and at most nTickets
+	// are outstanding (see serviceOnce())
+	typedef struct {
+		dmaServiceCore* self;
+		void* context;
+	} ticket_t;
+
+	dmaFeedJobs& jobs;
+
+	// application => service core
+	spscQueue<request_t> requests;
+	// service core => application
+	spscQueue<completion_t> completions;
+
+	ticket_t* const tickets;
+	const unsigned int nTickets;
+	// requests forwarded to jobs (service core loop only)
+	unsigned int nForwarded = 0;
+	// job callbacks so far (service core, also interrupt context)
+	std::atomic<unsigned int> nCompleted{0};
+
+	std::atomic<bool> stopRequested{false};
+};
+#endif
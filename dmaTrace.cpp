@@ -0,0 +1,43 @@
+#include "dmaTrace.h"
+
+#ifndef DEBUG
+extern void xil_printf(const char *format, ...);
+#endif
+
+#if DMAFEED_TRACE
+namespace {
+// indexed by event_e
+const char* const eventName[dmaTrace::TRACE_NEVENTTYPES] = {"runStart", "irqEntry", "irqExit", "toHw", "fromHw", "done", "error", "reset"};
+} // namespace
+
+dmaTrace::event_t dmaTrace::events[DMAFEED_TRACE_NEVENTS];
+std::atomic<u32> dmaTrace::next(0);
+std::atomic<bool> dmaTrace::enabled(true);
+
+void dmaTrace::setEnabled(bool newState){
+	enabled.store(newState, std::memory_order_relaxed);
+}
+
+void dmaTrace::dump(){
+	u32 n = next.load(std::memory_order_relaxed);
+	u32 first = (n > DMAFEED_TRACE_NEVENTS) ? n - DMAFEED_TRACE_NEVENTS : 0;
+	// xil_printf has no 64 bit conversion => timestamps as two hex words
+	xil_printf("# dmaTrace countsPerSecond=%d events=%d overwritten=%d\r\n", (int)COUNTS_PER_SECOND, (int)(n - first), (int)first);
+	xil_printf("t,devId,dir,event,arg\r\n");
+	for (u32 ix = first; ix != n; ++ix){
+		const event_t& e = events[ix & (DMAFEED_TRACE_NEVENTS - 1)];
+		xil_printf("%08x%08x,%d,%s,%s,%08x\r\n", (u32)(e.t >> 32), (u32)e.t, (int)e.devId, e.isRx ? "rx" : "tx", eventName[e.event], e.arg);
+	}
+	xil_printf("# dmaTrace end\r\n");
+}
+
+void dmaTrace::clear(){
+	next.store(0, std::memory_order_relaxed);
+}
+#else
+void dmaTrace::setEnabled(bool){}
+void dmaTrace::dump(){
+	xil_printf("# dmaTrace: not compiled in (DMAFEED_TRACE=0)\r\n");
+}
+void dmaTrace::clear(){}
+#endif
@@ -0,0 +1,83 @@
+#ifndef DMATRACE_H
+#define DMATRACE_H
+#include "xil_types.h"
+#include "xtime_l.h"
+#include <atomic>
+
+// compile with -DDMAFEED_TRACE=1 to record timestamped events of all dmaFeed instances into dmaTrace (otherwise compiled out)
+#ifndef DMAFEED_TRACE
+#	define DMAFEED_TRACE 0
+#endif
+// events kept by dmaTrace (power of two), older ones are overwritten
+#ifndef DMAFEED_TRACE_NEVENTS
+#	define DMAFEED_TRACE_NEVENTS 4096
+#endif
+
+// fixed-size event ring shared by all dmaFeed instances, for timeline analysis (late interrupt, starved ring, stalled engine)
+// - record() claims a slot with one atomic increment and fills it in place: no lock, usable from interrupt callbacks and
+//   application context at the same time. Cost: timestamp read, increment, four stores
+// - dump() prints the ring as text for tools/dmaTrace.py (timeline or Chrome trace JSON). Call while no instance is active,
+//   or after setEnabled(false) to freeze the ring right after the event of interest
+class dmaTrace{
+public:
+	typedef enum {
+		// runStart(), arg: 0
+		TRACE_RUN_START=0,
+		// interrupt callback entry, arg: IRQ status bits
+		TRACE_IRQ_ENTRY,
+		// interrupt callback exit, arg: BDs collected
+		TRACE_IRQ_EXIT,
+		// BdRingToHw(), arg: BD count
+		TRACE_TO_HW,
+		// BdRingFromHw() with completed BDs, arg: BD count
+		TRACE_FROM_HW,
+		// done(), arg: 0
+		TRACE_DONE,
+		// error status seen by interrupt callback or run_poll(), arg: IRQ status bits
+		TRACE_ERROR,
+		// DMA reset (error or abort()), arg: 0
+		TRACE_RESET,
+		TRACE_NEVENTTYPES} event_e;
+
+	typedef struct {
+		XTime t;
+		u16 event; // event_e
+		u8 devId;
+		u8 isRx;
+		u32 arg;
+	} event_t;
+
+	static void record(event_e event, u32 devId, bool isRx, u32 arg){
+#if DMAFEED_TRACE
+		if (!enabled.load(std::memory_order_relaxed))
+			return;
+		event_t& e = events[next.fetch_add(1, std::memory_order_relaxed) & (DMAFEED_TRACE_NEVENTS - 1)];
+		XTime_GetTime(&e.t);
+		e.event = (u16)event;
+		e.devId = (u8)devId;
+		e.isRx = isRx;
+		e.arg = arg;
+#else
+		(void)event; (void)devId; (void)isRx; (void)arg;
+#endif
+	}
+
+	// stops / resumes recording (enabled on startup)
+	static void setEnabled(bool newState);
+
+	// prints the recorded events, oldest first, with xil_printf (see tools/dmaTrace.py for the format)
+	static void dump();
+
+	// discards all recorded events
+	static void clear();
+private:
+	dmaTrace() = delete;
+#if DMAFEED_TRACE
+	static_assert(!(DMAFEED_TRACE_NEVENTS & (DMAFEED_TRACE_NEVENTS - 1)), "DMAFEED_TRACE_NEVENTS must be a power of two");
+	static event_t events[DMAFEED_TRACE_NEVENTS];
+	// events recorded since clear(), wraps around
+	static std::atomic<u32> next;
+	static std::atomic<bool> enabled;
+#endif
+};
+#endif
@@ -0,0 +1,62 @@
+#ifndef XAXIDMA_H
+#define XAXIDMA_H
+// host (Linux) stand-in for the Xilinx AXI DMA driver header of the same name
+// Each device is modelled as MM2S -> AXI-Stream FIFO -> S2MM loopback serviced by its own thread (xaxidma_host.cpp).
+#include "xaxidma_bdring.h"
+#include "xil_mmu.h"
+
+#define XAXIDMA_MAX_NUM_CHANNELS 16
+#define XAXIDMA_DMA_TO_DEVICE 0x00
+#define XAXIDMA_DEVICE_TO_DMA 0x01
+
+typedef struct {
+	u32 DeviceId;
+	UINTPTR BaseAddr;
+	int HasStsCntrlStrm;
+	int HasMm2S;
+	int HasMm2SDRE;
+	int Mm2SDataWidth;
+	int HasS2Mm;
+	int HasS2MmDRE;
+	int S2MmDataWidth;
+	int HasSg;
+	int Mm2sNumChannels;
+	int S2MmNumChannels;
+	int Mm2SBurstSize;
+	int S2MmBurstSize;
+	int MicroDmaMode;
+	int AddrWidth;
+	int SgLengthWidth;
+} XAxiDma_Config;
+
+typedef struct {
+	UINTPTR RegBase;
+	int HasMm2S;
+	int HasS2Mm;
+	int Initialized;
+	int HasSg;
+	XAxiDma_BdRing TxBdRing;
+	XAxiDma_BdRing RxBdRing[XAXIDMA_MAX_NUM_CHANNELS];
+	int TxNumChannels;
+	int RxNumChannels;
+	int MicroDmaMode;
+	int AddrWidth;
+} XAxiDma;
+
+#define XAxiDma_GetTxRing(InstancePtr) (&((InstancePtr)->TxBdRing))
+#define XAxiDma_GetRxRing(InstancePtr) (&((InstancePtr)->RxBdRing[0]))
+#define XAxiDma_GetRxIndexRing(InstancePtr, RingIndex) (&((InstancePtr)->RxBdRing[RingIndex]))
+#define XAxiDma_HasSg(InstancePtr) (((InstancePtr)->HasSg) ? TRUE : FALSE)
+
+#ifndef TRUE
+#	define TRUE 1
+#	define FALSE 0
+#endif
+
+XAxiDma_Config *XAxiDma_LookupConfig(u32 DeviceId);
+int XAxiDma_CfgInitialize(XAxiDma *InstancePtr, XAxiDma_Config *Config);
+void XAxiDma_Reset(XAxiDma *InstancePtr);
+int XAxiDma_ResetIsDone(XAxiDma *InstancePtr);
+// cyclic BD mode of the channel (DMACR bit, cleared by reset). Set while halted, before XAxiDma_BdRingStart()
+int XAxiDma_SelectCyclicMode(XAxiDma *InstancePtr, int Direction, int Select);
+#endif
@@ -0,0 +1,73 @@
+#ifndef XAXIDMA_BD_H
+#define XAXIDMA_BD_H
+// host (Linux) stand-in for the Xilinx AXI DMA driver header of the same name
+// BD layout, masks and accessors follow the driver; addresses use the _MSB words for 64 bit host pointers.
+#include <string.h>
+#include "xil_types.h"
+#include "xstatus.h"
+#include "xil_cache.h"
+#include "xaxidma_hw.h"
+
+// === BD layout (byte offsets) ===
+#define XAXIDMA_BD_NDESC_OFFSET 0x00
+#define XAXIDMA_BD_NDESC_MSB_OFFSET 0x04
+#define XAXIDMA_BD_BUFA_OFFSET 0x08
+#define XAXIDMA_BD_BUFA_MSB_OFFSET 0x0C
+#define XAXIDMA_BD_MCCTL_OFFSET 0x10
+#define XAXIDMA_BD_STRIDE_VSIZE_OFFSET 0x14
+#define XAXIDMA_BD_CTRL_LEN_OFFSET 0x18
+#define XAXIDMA_BD_STS_OFFSET 0x1C
+#define XAXIDMA_BD_USR0_OFFSET 0x20
+#define XAXIDMA_BD_ID_OFFSET 0x34
+#define XAXIDMA_BD_HAS_STSCNTRL_OFFSET 0x38
+#define XAXIDMA_BD_HAS_DRE_OFFSET 0x3C
+
+#define XAXIDMA_BD_START_CLEAR 8
+#define XAXIDMA_BD_BYTES_TO_CLEAR 48
+#define XAXIDMA_BD_NUM_WORDS 16U
+#define XAXIDMA_BD_MINIMUM_ALIGNMENT 0x40
+
+// === control word ===
+#define XAXIDMA_BD_CTRL_TXSOF_MASK 0x08000000
+#define XAXIDMA_BD_CTRL_TXEOF_MASK 0x04000000
+#define XAXIDMA_BD_CTRL_ALL_MASK 0x0C000000
+
+// === status word ===
+#define XAXIDMA_BD_STS_COMPLETE_MASK 0x80000000
+#define XAXIDMA_BD_STS_DEC_ERR_MASK 0x40000000
+#define XAXIDMA_BD_STS_SLV_ERR_MASK 0x20000000
+#define XAXIDMA_BD_STS_INT_ERR_MASK 0x10000000
+#define XAXIDMA_BD_STS_ALL_ERR_MASK 0x70000000
+#define XAXIDMA_BD_STS_RXSOF_MASK 0x08000000
+#define XAXIDMA_BD_STS_RXEOF_MASK 0x04000000
+#define XAXIDMA_BD_STS_ALL_MASK 0xFC000000
+
+// === multichannel control word ===
+#define XAXIDMA_BD_TDEST_FIELD_MASK 0x0000000F
+#define XAXIDMA_BD_TID_FIELD_MASK 0x00000F00
+#define XAXIDMA_BD_TID_FIELD_SHIFT 8
+
+typedef u32 XAxiDma_Bd[XAXIDMA_BD_NUM_WORDS];
+
+// BD words are shared with the engine thread of the model (the hardware on the board): atomic accesses, acquire pairs with
+// the engine's release of the status word (data before status), release publishes the CPU's writes to a BD
+#define XAxiDma_BdRead(BaseAddress, Offset) __atomic_load_n((u32 *)((UINTPTR)(void *)(BaseAddress) + (u32)(Offset)), __ATOMIC_ACQUIRE)
+#define XAxiDma_BdWrite(BaseAddress, Offset, Data) __atomic_store_n((u32 *)((UINTPTR)(void *)(BaseAddress) + (u32)(Offset)), (u32)(Data), __ATOMIC_RELEASE)
+
+#define XAxiDma_BdClear(BdPtr) memset((void *)(((UINTPTR)(BdPtr)) + XAXIDMA_BD_START_CLEAR), 0, XAXIDMA_BD_BYTES_TO_CLEAR)
+#define XAxiDma_BdGetCtrl(BdPtr) (XAxiDma_BdRead((BdPtr), XAXIDMA_BD_CTRL_LEN_OFFSET) & XAXIDMA_BD_CTRL_ALL_MASK)
+#define XAxiDma_BdGetSts(BdPtr) (XAxiDma_BdRead((BdPtr), XAXIDMA_BD_STS_OFFSET) & XAXIDMA_BD_STS_ALL_MASK)
+#define XAxiDma_BdGetLength(BdPtr, LengthMask) (XAxiDma_BdRead((BdPtr), XAXIDMA_BD_CTRL_LEN_OFFSET) & (LengthMask))
+#define XAxiDma_BdGetActualLength(BdPtr, LengthMask) (XAxiDma_BdRead((BdPtr), XAXIDMA_BD_STS_OFFSET) & (LengthMask))
+#define XAxiDma_BdSetId(BdPtr, Id) (XAxiDma_BdWrite((BdPtr), XAXIDMA_BD_ID_OFFSET, (UINTPTR)(Id)))
+#define XAxiDma_BdGetId(BdPtr) (XAxiDma_BdRead((BdPtr), XAXIDMA_BD_ID_OFFSET))
+#define XAxiDma_BdGetBufAddr(BdPtr) \
+	((UINTPTR)XAxiDma_BdRead((BdPtr), XAXIDMA_BD_BUFA_OFFSET) | ((UINTPTR)XAxiDma_BdRead((BdPtr), XAXIDMA_BD_BUFA_MSB_OFFSET) << 16 << 16))
+#define XAxiDma_BdGetTDest(BdPtr) (XAxiDma_BdRead((BdPtr), XAXIDMA_BD_MCCTL_OFFSET) & XAXIDMA_BD_TDEST_FIELD_MASK)
+#define XAxiDma_BdSetTDest(BdPtr, TDest) \
+	XAxiDma_BdWrite((BdPtr), XAXIDMA_BD_MCCTL_OFFSET, (XAxiDma_BdRead((BdPtr), XAXIDMA_BD_MCCTL_OFFSET) & ~XAXIDMA_BD_TDEST_FIELD_MASK) | ((TDest) & XAXIDMA_BD_TDEST_FIELD_MASK))
+
+int XAxiDma_BdSetLength(XAxiDma_Bd *BdPtr, u32 LenBytes, u32 LengthMask);
+u32 XAxiDma_BdSetBufAddr(XAxiDma_Bd *BdPtr, UINTPTR Addr);
+void XAxiDma_BdSetCtrl(XAxiDma_Bd *BdPtr, u32 Data);
+#endif
@@ -0,0 +1,73 @@
+#ifndef XAXIDMA_BDRING_H
+#define XAXIDMA_BDRING_H
+// host (Linux) stand-in for the Xilinx AXI DMA driver header of the same name
+#include "xaxidma_bd.h"
+
+#define XAXIDMA_NO_CHANGE 0xFFFFFFFF
+#define XAXIDMA_ALL_BDS 0x0FFFFFFF
+
+#define XAXIDMA_IRQ_IOC_MASK 0x00001000
+#define XAXIDMA_IRQ_DELAY_MASK 0x00002000
+#define XAXIDMA_IRQ_ERROR_MASK 0x00004000
+#define XAXIDMA_IRQ_ALL_MASK 0x00007000
+
+#define XAXIDMA_COALESCE_MAX 0xFF
+#define XAXIDMA_DELAY_MAX 0xFF
+
+#define AXIDMA_CHANNEL_NOT_HALTED 1
+#define AXIDMA_CHANNEL_HALTED 2
+
+typedef struct {
+	UINTPTR ChanBase; // host: points to the channel model
+	int IsRxChannel;
+	int RunState;
+	int HasStsCntrlStrm;
+	int HasDRE;
+	int DataWidth;
+	int Addr_ext;
+	u32 MaxTransferLen;
+	UINTPTR FirstBdPhysAddr;
+	UINTPTR FirstBdAddr;
+	UINTPTR LastBdAddr;
+	u32 Length;
+	UINTPTR Separation;
+	XAxiDma_Bd *FreeHead;
+	XAxiDma_Bd *PreHead;
+	XAxiDma_Bd *HwHead;
+	XAxiDma_Bd *HwTail;
+	XAxiDma_Bd *PostHead;
+	XAxiDma_Bd *BdaRestart;
+	int FreeCnt;
+	int PreCnt;
+	int HwCnt;
+	int PostCnt;
+	int AllCnt;
+	int RingIndex;
+	int Cyclic;
+} XAxiDma_BdRing;
+
+#define XAxiDma_BdRingCntCalc(Alignment, Bytes) (u32)((Bytes)/((sizeof(XAxiDma_Bd)+((Alignment)-1))&~((Alignment)-1)))
+#define XAxiDma_BdRingMemCalc(Alignment, NumBd) (int)((sizeof(XAxiDma_Bd)+((Alignment)-1)) & ~((Alignment)-1))*(NumBd)
+#define XAxiDma_BdRingGetCnt(RingPtr) ((RingPtr)->AllCnt)
+#define XAxiDma_BdRingGetFreeCnt(RingPtr) ((RingPtr)->FreeCnt)
+#define XAxiDma_BdRingNext(RingPtr, BdPtr) \
+	(((UINTPTR)(BdPtr) >= (RingPtr)->LastBdAddr) ? (UINTPTR)(RingPtr)->FirstBdAddr : (UINTPTR)((UINTPTR)(BdPtr) + (RingPtr)->Separation))
+#define XAxiDma_BdRingPrev(RingPtr, BdPtr) \
+	(((UINTPTR)(BdPtr) <= (RingPtr)->FirstBdAddr) ? (XAxiDma_Bd*)(RingPtr)->LastBdAddr : (XAxiDma_Bd*)((UINTPTR)(BdPtr) - (RingPtr)->Separation))
+
+int XAxiDma_BdRingCreate(XAxiDma_BdRing *RingPtr, UINTPTR PhysAddr, UINTPTR VirtAddr, u32 Alignment, int BdCount);
+int XAxiDma_BdRingClone(XAxiDma_BdRing *RingPtr, XAxiDma_Bd *SrcBdPtr);
+int XAxiDma_BdRingAlloc(XAxiDma_BdRing *RingPtr, int NumBd, XAxiDma_Bd **BdSetPtr);
+int XAxiDma_BdRingUnAlloc(XAxiDma_BdRing *RingPtr, int NumBd, XAxiDma_Bd *BdSetPtr);
+int XAxiDma_BdRingToHw(XAxiDma_BdRing *RingPtr, int NumBd, XAxiDma_Bd *BdSetPtr);
+int XAxiDma_BdRingFromHw(XAxiDma_BdRing *RingPtr, int BdLimit, XAxiDma_Bd **BdSetPtr);
+int XAxiDma_BdRingFree(XAxiDma_BdRing *RingPtr, int NumBd, XAxiDma_Bd *BdSetPtr);
+int XAxiDma_BdRingStart(XAxiDma_BdRing *RingPtr);
+int XAxiDma_BdRingEnableCyclicDMA(XAxiDma_BdRing *RingPtr);
+int XAxiDma_BdRingSetCoalesce(XAxiDma_BdRing *RingPtr, u32 Counter, u32 Timer);
+void XAxiDma_BdRingGetCoalesce(XAxiDma_BdRing *RingPtr, u32 *CounterPtr, u32 *TimerPtr);
+void XAxiDma_BdRingIntEnable(XAxiDma_BdRing *RingPtr, u32 Mask);
+void XAxiDma_BdRingIntDisable(XAxiDma_BdRing *RingPtr, u32 Mask);
+u32 XAxiDma_BdRingGetIrq(XAxiDma_BdRing *RingPtr);
+void XAxiDma_BdRingAckIrq(XAxiDma_BdRing *RingPtr, u32 Mask);
+#endif
@@ -0,0 +1,872 @@
+// host software model: AXI DMA in scatter-gather mode, MM2S looped back to S2MM through an AXI-Stream FIFO
+// - BD ring bookkeeping follows the driver (xaxidma_bdring.c): the CPU side owns all ring counters, the "hardware" only
+//   reads BDs between CURDESC and TAILDESC and writes back their status word
+// - each device runs on its own engine thread. Register accesses from the CPU take the engine lock.
+// - multichannel S2MM (S2MmNumChannels > 1): one descriptor queue per channel, selected by the TDEST of each packet (MM2S
+//   takes it from the first BD of the packet). Interrupt and coalescing registers are shared by all channels.
+// - interrupts: IOC per completed packet (TXEOF / TLAST), threshold counter, delay timer, error. Delivered via XHost_RaiseInterrupt()
+// - cyclic BD mode (XAxiDma_SelectCyclicMode()): the sequencer follows the BD links endlessly and ignores TAILDESC once started
+// - XAxiDma_ReadReg() / WriteReg(): DMACR and DMASR of a channel (ChanBase). Clearing DMACR.RS halts it, XAxiDma_BdRingStart() restarts
+#include "xaxidma.h"
+#include "xparameters.h"
+#include "xhost_model.h"
+
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <deque>
+#include <vector>
+#include <cassert>
+
+namespace {
+typedef std::chrono::steady_clock clk;
+
+// one delay timer unit (C_DLYTMR_RESOLUTION SG clocks on the board)
+const std::chrono::nanoseconds delayTimerUnit(1000);
+
+const u32 fifoDepthDefault = 0x8000;
+
+struct hostDmaEngine;
+
+// descriptor queue: CURDESC / TAILDESC and sequencer state. MM2S has one, S2MM one per channel (TDEST) in multichannel mode
+struct hostDmaQueue{
+	// === registers ===
+	bool running = false; // ring started (DMACR.RS)
+	UINTPTR curDesc = 0; // CURDESC
+	UINTPTR tailDesc = 0; // TAILDESC
+
+	// === sequencer ===
+	// a BD between CURDESC and TAILDESC is waiting to be processed
+	bool fetching = false;
+	// last processed BD (0: none since start)
+	UINTPTR lastDone = 0;
+	// bytes moved for the BD at curDesc
+	u32 bdOffset = 0;
+	// S2MM: BD at curDesc was started at a packet boundary
+	bool bdSof = false;
+	// inside a packet (S2MM: SOF seen, MM2S: TDEST sent, no TLAST yet)
+	bool inPacket = false;
+
+	void reset(){
+		running = false;
+		curDesc = tailDesc = 0;
+		fetching = false;
+		lastDone = 0;
+		bdOffset = 0;
+		bdSof = inPacket = false;
+	}
+};
+
+// MM2S or S2MM channel: interrupt / coalescing registers are shared by all its queues
+struct hostDmaChannel{
+	hostDmaEngine* engine = NULL;
+	bool isRx = false;
+	u32 irqId = 0;
+
+	// === registers ===
+	u32 irqEnable = 0; // DMACR IRQ enable bits
+	u32 irqStatus = 0; // DMASR IRQ bits (write 1 to clear)
+	u32 irqThreshold = 1; // DMACR.IRQThreshold
+	u32 irqDelay = 0; // DMACR.IRQDelay
+	bool cyclic = false; // DMACR.Cyclic BD Enable
+
+	// descriptor queues, indexed by XAxiDma_BdRing::RingIndex
+	hostDmaQueue q[XAXIDMA_MAX_NUM_CHANNELS];
+	u32 nQueues = 1;
+
+	// === coalescing ===
+	// IOC events left until the threshold interrupt
+	u32 thresholdCount = 1;
+	bool delayArmed = false;
+	clk::time_point delayDeadline;
+	// countdown to an injected error (0: off)
+	u32 injectErrorCountdown = 0;
+
+	void reset(){
+		irqEnable = irqStatus = 0;
+		irqThreshold = thresholdCount = 1;
+		irqDelay = 0;
+		cyclic = false;
+		for (hostDmaQueue& qu : q)
+			qu.reset();
+		delayArmed = false;
+	}
+};
+
+struct hostDmaEngine{
+	std::mutex m;
+	std::condition_variable cv;
+	hostDmaChannel tx;
+	hostDmaChannel rx;
+	u32 lengthMask = 0;
+
+	// === AXI-Stream FIFO between MM2S and S2MM ===
+	std::vector<u8> fifo;
+	u32 fifoDepthNext = fifoDepthDefault; // applied on reset of the FIFO
+	bool fifoResetOnDmaReset = false; // XHost_AxiDmaSetFifoResetOnDmaReset()
+	u64 fifoWrCount = 0; // total bytes written
+	u64 fifoRdCount = 0; // total bytes read
+	std::deque<u64> fifoPacketEnds; // fifoWrCount at each TLAST
+	std::deque<u32> fifoPacketDests; // TDEST of each packet started in the FIFO and not yet fully read
+	bool fifoWrInPacket = false; // external source (XHost_AxiDmaStreamWrite()) is inside a packet
+
+	hostDmaEngine(u32 irqTx, u32 irqRx, u32 nRxChannels, u32 lengthMask) : lengthMask(lengthMask){
+		tx.engine = rx.engine = this;
+		rx.isRx = true;
+		rx.nQueues = nRxChannels;
+		tx.irqId = irqTx;
+		rx.irqId = irqRx;
+		resetLocked(/*fifoToo*/true);
+		std::thread([this]{run();}).detach(); // lives for the whole process, like the hardware
+	}
+
+	// fifoToo: also the FIFO (system reset, or wired to the DMA reset). An empty FIFO is reset anyway (applies fifoDepthNext)
+	void resetLocked(bool fifoToo){
+		bool txInPacket = tx.q[0].inPacket;
+		tx.reset();
+		rx.reset();
+		if (!fifoToo && ((fifoWrCount != fifoRdCount) || fifoWrInPacket || !fifoPacketDests.empty())){
+			// data stays in flight: S2MM receives it after the reset. A packet MM2S left open continues with its next data
+			tx.q[0].inPacket = txInPacket;
+			return;
+		}
+		fifo.assign(fifoDepthNext, 0);
+		fifoWrCount = fifoRdCount = 0;
+		fifoPacketEnds.clear();
+		fifoPacketDests.clear();
+		fifoWrInPacket = false;
+	}
+
+	static u32 rd(UINTPTR bd, u32 offset){
+		return XAxiDma_BdRead(bd, offset);
+	}
+
+	static UINTPTR nextDesc(UINTPTR bd){
+		return (UINTPTR)rd(bd, XAXIDMA_BD_NDESC_OFFSET) | ((UINTPTR)rd(bd, XAXIDMA_BD_NDESC_MSB_OFFSET) << 16 << 16);
+	}
+
+	// hardware writes back the BD status word. Release => CPU sees data before status
+	static void writeSts(UINTPTR bd, u32 sts){
+		__atomic_store_n((u32*)(bd + XAXIDMA_BD_STS_OFFSET), sts, __ATOMIC_RELEASE);
+	}
+
+	void setIrq(hostDmaChannel& ch, u32 bits){
+		ch.irqStatus |= bits;
+		if (bits & ch.irqEnable)
+			XHost_RaiseInterrupt(ch.irqId);
+	}
+
+	// packet completion event (IOC) towards coalescing logic
+	void iocEvent(hostDmaChannel& ch){
+		if (--ch.thresholdCount == 0){
+			ch.thresholdCount = ch.irqThreshold;
+			ch.delayArmed = false;
+			setIrq(ch, XAXIDMA_IRQ_IOC_MASK);
+		} else if (ch.irqDelay){
+			ch.delayArmed = true;
+			ch.delayDeadline = clk::now() + ch.irqDelay * delayTimerUnit;
+		}
+	}
+
+	// halts the whole channel (all queues)
+	void error(hostDmaChannel& ch, hostDmaQueue& q, UINTPTR bd, u32 errBits){
+		writeSts(bd, errBits | q.bdOffset);
+		halt(ch);
+		setIrq(ch, XAXIDMA_IRQ_ERROR_MASK);
+	}
+
+	// retires BD at curDesc and advances to the next one (cyclic: past the tail, too)
+	void complete(hostDmaChannel& ch, hostDmaQueue& q, u32 sts, bool ioc){
+		UINTPTR bd = q.curDesc;
+		writeSts(bd, XAXIDMA_BD_STS_COMPLETE_MASK | sts);
+		q.lastDone = bd;
+		q.bdOffset = 0;
+		if ((bd == q.tailDesc) && !ch.cyclic)
+			q.fetching = false;
+		else
+			q.curDesc = nextDesc(bd);
+		if (ioc)
+			iocEvent(ch);
+	}
+
+	// checks whether the BD at curDesc may be processed. Returns false on error
+	bool bdStart(hostDmaChannel& ch, hostDmaQueue& q){
+		UINTPTR bd = q.curDesc;
+		if (q.bdOffset)
+			return true; // already started
+		u32 len = rd(bd, XAXIDMA_BD_CTRL_LEN_OFFSET) & lengthMask;
+		if (!len || !XAxiDma_BdGetBufAddr(bd)){
+			error(ch, q, bd, XAXIDMA_BD_STS_INT_ERR_MASK);
+			return false;
+		}
+		if (ch.injectErrorCountdown && !--ch.injectErrorCountdown){
+			error(ch, q, bd, XAXIDMA_BD_STS_SLV_ERR_MASK);
+			return false;
+		}
+		return true;
+	}
+
+	// copies n bytes between buf and the FIFO at absolute stream position pos, wrapping around the FIFO end
+	void fifoCopy(const void* buf, u64 pos, u64 n, bool toFifo){
+		u64 ofs = pos % fifo.size();
+		u64 n1 = fifo.size() - ofs;
+		if (n1 > n)
+			n1 = n;
+		if (toFifo){
+			memcpy(&fifo[ofs], buf, n1);
+			memcpy(&fifo[0], (const u8*)buf + n1, n - n1);
+		} else {
+			memcpy((void*)buf, &fifo[ofs], n1);
+			memcpy((u8*)buf + n1, &fifo[0], n - n1);
+		}
+	}
+
+	// MM2S: moves data from the BD buffer into the FIFO. Returns whether progress was made
+	bool stepTx(){
+		hostDmaChannel& ch = tx;
+		hostDmaQueue& q = ch.q[0];
+		if (!q.running || !q.fetching)
+			return false;
+		u32 room = (u32)(fifo.size() - (fifoWrCount - fifoRdCount));
+		if (!room)
+			return false;
+		if (!bdStart(ch, q))
+			return true;
+
+		UINTPTR bd = q.curDesc;
+		u32 ctrl = rd(bd, XAXIDMA_BD_CTRL_LEN_OFFSET);
+		u32 len = ctrl & lengthMask;
+		if (!q.inPacket){
+			// TDEST of the packet comes from its first BD
+			fifoPacketDests.push_back(XAxiDma_BdGetTDest(bd));
+			q.inPacket = true;
+		}
+		const u8* src = (const u8*)XAxiDma_BdGetBufAddr(bd) + q.bdOffset;
+		u32 n = len - q.bdOffset;
+		if (n > room)
+			n = room;
+		fifoCopy(src, fifoWrCount, n, /*toFifo*/true);
+		fifoWrCount += n;
+		q.bdOffset += n;
+
+		if (q.bdOffset < len)
+			return true;
+		bool eof = ctrl & XAXIDMA_BD_CTRL_TXEOF_MASK;
+		if (eof){
+			fifoPacketEnds.push_back(fifoWrCount);
+			q.inPacket = false;
+		}
+		complete(ch, q, len, /*IOC*/eof);
+		return true;
+	}
+
+	// S2MM: moves data from the FIFO into a BD buffer of the queue selected by the packet's TDEST. Returns whether progress was made
+	// (a packet for a queue without BDs blocks the stream, like the hardware)
+	bool stepRx(){
+		hostDmaChannel& ch = rx;
+		u64 avail = fifoWrCount - fifoRdCount;
+		if (!avail)
+			return false;
+		assert(!fifoPacketDests.empty());
+		u32 dest = fifoPacketDests.front();
+		assert((dest < ch.nQueues) && "XHost: packet TDEST has no S2MM channel");
+		hostDmaQueue& q = ch.q[dest];
+		if (!q.running || !q.fetching)
+			return false;
+		if (!bdStart(ch, q))
+			return true;
+
+		UINTPTR bd = q.curDesc;
+		u32 len = rd(bd, XAXIDMA_BD_CTRL_LEN_OFFSET) & lengthMask;
+		if (!q.bdOffset){
+			q.bdSof = !q.inPacket;
+			q.inPacket = true;
+		}
+		u64 n = len - q.bdOffset;
+		if (n > avail)
+			n = avail;
+		if (!fifoPacketEnds.empty() && (n > fifoPacketEnds.front() - fifoRdCount))
+			n = fifoPacketEnds.front() - fifoRdCount; // stop at TLAST
+		u8* buf = (u8*)XAxiDma_BdGetBufAddr(bd) + q.bdOffset;
+		fifoCopy(buf, fifoRdCount, n, /*toFifo*/false);
+		fifoRdCount += n;
+		q.bdOffset += (u32)n;
+
+		bool eof = !fifoPacketEnds.empty() && (fifoPacketEnds.front() == fifoRdCount);
+		if (eof){
+			fifoPacketEnds.pop_front();
+			fifoPacketDests.pop_front();
+			q.inPacket = false;
+		}
+		if (eof || (q.bdOffset == len)){
+			u32 sts = q.bdOffset;
+			if (q.bdSof)
+				sts |= XAXIDMA_BD_STS_RXSOF_MASK;
+			if (eof)
+				sts |= XAXIDMA_BD_STS_RXEOF_MASK;
+			// multichannel BDs report the channel in the MCCTL word
+			XAxiDma_BdWrite(bd, XAXIDMA_BD_MCCTL_OFFSET, (XAxiDma_BdRead(bd, XAXIDMA_BD_MCCTL_OFFSET) & ~XAXIDMA_BD_TDEST_FIELD_MASK) | dest);
+			complete(ch, q, sts, /*IOC*/eof);
+		}
+		return true;
+	}
+
+	// fires expired delay timers. Returns the earliest remaining deadline, if any
+	bool timers(clk::time_point& next){
+		bool any = false;
+		clk::time_point now = clk::now();
+		for (hostDmaChannel* ch : {&tx, &rx}){
+			if (!ch->delayArmed)
+				continue;
+			if (now >= ch->delayDeadline){
+				ch->delayArmed = false;
+				ch->thresholdCount = ch->irqThreshold;
+				setIrq(*ch, XAXIDMA_IRQ_DELAY_MASK);
+			} else if (!any || (ch->delayDeadline < next)){
+				next = ch->delayDeadline;
+				any = true;
+			}
+		}
+		return any;
+	}
+
+	void run(){
+		std::unique_lock<std::mutex> lk(m);
+		while (true){
+			bool progress = false;
+			// move a bounded amount per lock hold so CPU register accesses are not starved
+			for (int ix = 0; ix < 16; ++ix){
+				bool p = stepTx();
+				p |= stepRx();
+				if (!p)
+					break;
+				progress = true;
+			}
+			clk::time_point next;
+			bool timerPending = timers(next);
+			if (progress){
+				lk.unlock();
+				lk.lock();
+			} else if (timerPending)
+				cv.wait_until(lk, next);
+			else
+				cv.wait(lk);
+		}
+	}
+
+	// === register writes from the CPU side (call with m held) ===
+	void writeTail(hostDmaQueue& q, UINTPTR bd){
+		q.tailDesc = bd;
+		// the driver only writes TAILDESC for newly committed BDs => an idle queue always resumes (even at the same address after a full ring wrap)
+		if (q.running && !q.fetching){
+			if (q.lastDone)
+				q.curDesc = nextDesc(q.lastDone);
+			q.fetching = true;
+		}
+		cv.notify_all();
+	}
+
+	// DMACR.RS cleared: all queues of the channel stop fetching. Halts at once (the hardware first finishes a BD in progress)
+	void halt(hostDmaChannel& ch){
+		for (hostDmaQueue& qu : ch.q)
+			qu.running = qu.fetching = false;
+		ch.delayArmed = false;
+	}
+
+	void start(hostDmaQueue& q, UINTPTR firstBd){
+		if (q.running)
+			return;
+		q.curDesc = firstBd;
+		q.lastDone = 0;
+		q.bdOffset = 0;
+		q.running = true;
+	}
+};
+
+XAxiDma_Config configTable[XPAR_XAXIDMA_NUM_INSTANCES];
+hostDmaEngine* engines[XPAR_XAXIDMA_NUM_INSTANCES];
+const u32 irqIds[XPAR_XAXIDMA_NUM_INSTANCES][2] = {
+		{XPAR_FABRIC_AXIDMA_0_MM2S_INTROUT_VEC_ID, XPAR_FABRIC_AXIDMA_0_S2MM_INTROUT_VEC_ID},
+		{XPAR_FABRIC_AXIDMA_1_MM2S_INTROUT_VEC_ID, XPAR_FABRIC_AXIDMA_1_S2MM_INTROUT_VEC_ID},
+		{XPAR_FABRIC_AXIDMA_2_MM2S_INTROUT_VEC_ID, XPAR_FABRIC_AXIDMA_2_S2MM_INTROUT_VEC_ID},
+		{XPAR_FABRIC_AXIDMA_3_MM2S_INTROUT_VEC_ID, XPAR_FABRIC_AXIDMA_3_S2MM_INTROUT_VEC_ID},
+		{XPAR_FABRIC_AXIDMA_4_MM2S_INTROUT_VEC_ID, XPAR_FABRIC_AXIDMA_4_S2MM_INTROUT_VEC_ID}};
+const u32 nS2MmChannels[XPAR_XAXIDMA_NUM_INSTANCES] = {
+		XPAR_AXIDMA_0_NUM_S2MM_CHANNELS, XPAR_AXIDMA_1_NUM_S2MM_CHANNELS, XPAR_AXIDMA_2_NUM_S2MM_CHANNELS, XPAR_AXIDMA_3_NUM_S2MM_CHANNELS,
+		XPAR_AXIDMA_4_NUM_S2MM_CHANNELS};
+std::mutex enginesMutex;
+
+// engine for device index, created on first use
+hostDmaEngine* engineByIndex(u32 ix){
+	std::lock_guard<std::mutex> lk(enginesMutex);
+	if (!engines[ix])
+		engines[ix] = new hostDmaEngine(irqIds[ix][0], irqIds[ix][1], nS2MmChannels[ix], (1U << XPAR_AXI_DMA_0_SG_LENGTH_WIDTH) - 1); // never destroyed
+	return engines[ix];
+}
+
+hostDmaEngine* engineByDeviceId(u32 DeviceId){
+	XAxiDma_Config* c = XAxiDma_LookupConfig(DeviceId);
+	assert(c && "XHost: unknown DMA device");
+	return engineByIndex(c - configTable);
+}
+
+hostDmaChannel* chan(XAxiDma_BdRing* RingPtr){
+	return (hostDmaChannel*)RingPtr->ChanBase;
+}
+
+// CURDESC / TAILDESC of the ring (S2MM multichannel: one per RingIndex)
+hostDmaQueue* queue(XAxiDma_BdRing* RingPtr){
+	return &chan(RingPtr)->q[RingPtr->RingIndex];
+}
+
+UINTPTR bdPhys(XAxiDma_BdRing* RingPtr, XAxiDma_Bd* BdPtr){
+	return (UINTPTR)BdPtr - RingPtr->FirstBdAddr + RingPtr->FirstBdPhysAddr;
+}
+
+XAxiDma_Bd* bdAdvance(XAxiDma_BdRing* RingPtr, XAxiDma_Bd* BdPtr, int n){
+	UINTPTR a = (UINTPTR)BdPtr + n * RingPtr->Separation;
+	if (a > RingPtr->LastBdAddr)
+		a -= RingPtr->Length;
+	return (XAxiDma_Bd*)a;
+}
+
+void ringInit(XAxiDma_BdRing* RingPtr, hostDmaChannel* ch, int ringIndex, u32 lengthMask){
+	memset(RingPtr, 0, sizeof(*RingPtr));
+	// like the driver, all rings of a channel share its registers (ChanBase) and differ in RingIndex
+	RingPtr->ChanBase = (UINTPTR)ch;
+	RingPtr->RingIndex = ringIndex;
+	RingPtr->IsRxChannel = ch->isRx;
+	RingPtr->RunState = AXIDMA_CHANNEL_HALTED;
+	RingPtr->MaxTransferLen = lengthMask;
+	RingPtr->DataWidth = 4;
+}
+} // namespace
+
+void XHost_AxiDmaSetFifoDepth(u32 DeviceId, u32 NumBytes){
+	hostDmaEngine* e = engineByDeviceId(DeviceId);
+	std::lock_guard<std::mutex> lk(e->m);
+	e->fifoDepthNext = NumBytes;
+}
+
+void XHost_AxiDmaSetFifoResetOnDmaReset(u32 DeviceId, int Enable){
+	hostDmaEngine* e = engineByDeviceId(DeviceId);
+	std::lock_guard<std::mutex> lk(e->m);
+	e->fifoResetOnDmaReset = Enable;
+}
+
+void XHost_AxiDmaInjectError(u32 DeviceId, int IsRx, u32 NumBds){
+	hostDmaEngine* e = engineByDeviceId(DeviceId);
+	std::lock_guard<std::mutex> lk(e->m);
+	(IsRx ? e->rx : e->tx).injectErrorCountdown = NumBds;
+}
+
+u32 XHost_AxiDmaStreamWrite(u32 DeviceId, const void *Data, u32 NumBytes, int Tlast, u32 Tdest){
+	hostDmaEngine* e = engineByDeviceId(DeviceId);
+	std::lock_guard<std::mutex> lk(e->m);
+	u64 room = e->fifo.size() - (e->fifoWrCount - e->fifoRdCount);
+	u32 n = (NumBytes < room) ? NumBytes : (u32)room;
+	if (n && !e->fifoWrInPacket){
+		e->fifoPacketDests.push_back(Tdest);
+		e->fifoWrInPacket = true;
+	}
+	e->fifoCopy(Data, e->fifoWrCount, n, /*toFifo*/true);
+	e->fifoWrCount += n;
+	if (Tlast && (n == NumBytes) && n){
+		e->fifoPacketEnds.push_back(e->fifoWrCount);
+		e->fifoWrInPacket = false;
+	}
+	e->cv.notify_all();
+	return n;
+}
+
+u32 XHost_AxiDmaStreamRead(u32 DeviceId, void *Data, u32 NumBytes, int *Tlast){
+	hostDmaEngine* e = engineByDeviceId(DeviceId);
+	std::lock_guard<std::mutex> lk(e->m);
+	u64 avail = e->fifoWrCount - e->fifoRdCount;
+	u32 n = (NumBytes < avail) ? NumBytes : (u32)avail;
+	if (!e->fifoPacketEnds.empty() && (n > e->fifoPacketEnds.front() - e->fifoRdCount))
+		n = (u32)(e->fifoPacketEnds.front() - e->fifoRdCount); // stop at TLAST
+	e->fifoCopy(Data, e->fifoRdCount, n, /*toFifo*/false);
+	e->fifoRdCount += n;
+	bool eof = !e->fifoPacketEnds.empty() && (e->fifoPacketEnds.front() == e->fifoRdCount);
+	if (eof){
+		e->fifoPacketEnds.pop_front();
+		e->fifoPacketDests.pop_front();
+	}
+	if (Tlast)
+		*Tlast = eof;
+	e->cv.notify_all(); // room for MM2S
+	return n;
+}
+
+// === BD ===
+int XAxiDma_BdSetLength(XAxiDma_Bd *BdPtr, u32 LenBytes, u32 LengthMask){
+	if ((LenBytes <= 0) || (LenBytes > LengthMask))
+		return XST_INVALID_PARAM;
+	u32 v = XAxiDma_BdRead(BdPtr, XAXIDMA_BD_CTRL_LEN_OFFSET);
+	XAxiDma_BdWrite(BdPtr, XAXIDMA_BD_CTRL_LEN_OFFSET, (v & ~LengthMask) | LenBytes);
+	return XST_SUCCESS;
+}
+
+u32 XAxiDma_BdSetBufAddr(XAxiDma_Bd *BdPtr, UINTPTR Addr){
+	XAxiDma_BdWrite(BdPtr, XAXIDMA_BD_BUFA_OFFSET, (u32)Addr);
+	XAxiDma_BdWrite(BdPtr, XAXIDMA_BD_BUFA_MSB_OFFSET, (u32)((u64)Addr >> 32));
+	return XST_SUCCESS;
+}
+
+void XAxiDma_BdSetCtrl(XAxiDma_Bd *BdPtr, u32 Data){
+	u32 v = XAxiDma_BdRead(BdPtr, XAXIDMA_BD_CTRL_LEN_OFFSET);
+	v &= ~XAXIDMA_BD_CTRL_ALL_MASK;
+	v |= (Data & XAXIDMA_BD_CTRL_ALL_MASK);
+	XAxiDma_BdWrite(BdPtr, XAXIDMA_BD_CTRL_LEN_OFFSET, v);
+}
+
+// === device ===
+XAxiDma_Config *XAxiDma_LookupConfig(u32 DeviceId){
+	static bool init = false;
+	if (!init){
+		for (u32 ix = 0; ix < XPAR_XAXIDMA_NUM_INSTANCES; ++ix){
+			XAxiDma_Config& c = configTable[ix];
+			c.DeviceId = ix;
+			c.BaseAddr = 0x40400000 + 0x10000 * ix;
+			c.HasMm2S = c.HasS2Mm = 1;
+			c.Mm2SDataWidth = c.S2MmDataWidth = 32;
+			c.HasSg = 1;
+			c.Mm2sNumChannels = 1;
+			c.S2MmNumChannels = nS2MmChannels[ix];
+			c.Mm2SBurstSize = c.S2MmBurstSize = 16;
+			c.AddrWidth = 64;
+			c.SgLengthWidth = XPAR_AXI_DMA_0_SG_LENGTH_WIDTH;
+		}
+		init = true;
+	}
+	for (u32 ix = 0; ix < XPAR_XAXIDMA_NUM_INSTANCES; ++ix)
+		if (configTable[ix].DeviceId == DeviceId)
+			return &configTable[ix];
+	return NULL;
+}
+
+int XAxiDma_CfgInitialize(XAxiDma *InstancePtr, XAxiDma_Config *Config){
+	hostDmaEngine* e = engineByIndex(Config - configTable);
+	memset(InstancePtr, 0, sizeof(*InstancePtr));
+	InstancePtr->RegBase = Config->BaseAddr;
+	InstancePtr->HasMm2S = Config->HasMm2S;
+	InstancePtr->HasS2Mm = Config->HasS2Mm;
+	InstancePtr->HasSg = Config->HasSg;
+	InstancePtr->TxNumChannels = Config->Mm2sNumChannels;
+	InstancePtr->RxNumChannels = Config->S2MmNumChannels;
+	InstancePtr->AddrWidth = Config->AddrWidth;
+
+	ringInit(&InstancePtr->TxBdRing, &e->tx, /*ringIndex*/0, e->lengthMask);
+	for (int ix = 0; ix < InstancePtr->RxNumChannels; ++ix)
+		ringInit(&InstancePtr->RxBdRing[ix], &e->rx, ix, e->lengthMask);
+
+	// driver resets the engine as part of initialization
+	XAxiDma_Reset(InstancePtr);
+	InstancePtr->Initialized = XIL_COMPONENT_IS_READY;
+	return XST_SUCCESS;
+}
+
+void XAxiDma_Reset(XAxiDma *InstancePtr){
+	hostDmaEngine* e = chan(&InstancePtr->TxBdRing)->engine;
+	{
+		std::lock_guard<std::mutex> lk(e->m);
+		e->resetLocked(e->fifoResetOnDmaReset);
+	}
+	InstancePtr->TxBdRing.RunState = AXIDMA_CHANNEL_HALTED;
+	for (int ix = 0; ix < XAXIDMA_MAX_NUM_CHANNELS; ++ix)
+		InstancePtr->RxBdRing[ix].RunState = AXIDMA_CHANNEL_HALTED;
+}
+
+int XAxiDma_ResetIsDone(XAxiDma *InstancePtr){
+	(void)InstancePtr;
+	return 1; // reset completes immediately
+}
+
+int XAxiDma_SelectCyclicMode(XAxiDma *InstancePtr, int Direction, int Select){
+	if ((Direction != XAXIDMA_DMA_TO_DEVICE) && (Direction != XAXIDMA_DEVICE_TO_DMA))
+		return XST_INVALID_PARAM;
+	hostDmaChannel* ch = chan((Direction == XAXIDMA_DEVICE_TO_DMA) ? &InstancePtr->RxBdRing[0] : &InstancePtr->TxBdRing);
+	std::lock_guard<std::mutex> lk(ch->engine->m);
+	ch->cyclic = Select;
+	return XST_SUCCESS;
+}
+
+// === channel registers ===
+u32 XAxiDma_ReadReg(UINTPTR BaseAddress, u32 RegOffset){
+	hostDmaChannel* ch = (hostDmaChannel*)BaseAddress;
+	std::lock_guard<std::mutex> lk(ch->engine->m);
+	bool running = false;
+	bool fetching = false;
+	for (u32 ix = 0; ix < ch->nQueues; ++ix){
+		running |= ch->q[ix].running;
+		fetching |= ch->q[ix].fetching;
+	}
+	switch (RegOffset){
+	case XAXIDMA_CR_OFFSET:
+		return (running ? XAXIDMA_CR_RUNSTOP_MASK : 0) | (ch->cyclic ? XAXIDMA_CR_CYCLIC_MASK : 0) | ch->irqEnable
+				| (ch->irqThreshold << XAXIDMA_COALESCE_SHIFT) | (ch->irqDelay << XAXIDMA_DELAY_SHIFT);
+	case XAXIDMA_SR_OFFSET:
+		return (running ? 0 : XAXIDMA_HALTED_MASK) | ((running && !fetching) ? XAXIDMA_IDLE_MASK : 0) | ch->irqStatus;
+	default:
+		assert(0 && "XHost: register not modelled");
+		return 0;
+	}
+}
+
+void XAxiDma_WriteReg(UINTPTR BaseAddress, u32 RegOffset, u32 Data){
+	hostDmaChannel* ch = (hostDmaChannel*)BaseAddress;
+	assert((RegOffset == XAXIDMA_CR_OFFSET) && "XHost: register not modelled");
+	u32 cr = XAxiDma_ReadReg(BaseAddress, XAXIDMA_CR_OFFSET);
+	assert(!((cr ^ Data) & ~XAXIDMA_CR_RUNSTOP_MASK) && "XHost: DMACR write may only change RS");
+	assert(!(Data & XAXIDMA_CR_RUNSTOP_MASK) && "XHost: start through XAxiDma_BdRingStart()");
+	(void)RegOffset;
+	(void)cr;
+	std::lock_guard<std::mutex> lk(ch->engine->m);
+	ch->engine->halt(*ch);
+}
+
+// === BD ring ===
+int XAxiDma_BdRingCreate(XAxiDma_BdRing *RingPtr, UINTPTR PhysAddr, UINTPTR VirtAddr, u32 Alignment, int BdCount){
+	if ((BdCount <= 0) || (Alignment < XAXIDMA_BD_MINIMUM_ALIGNMENT) || (Alignment & (Alignment - 1)) || (VirtAddr & (Alignment - 1)))
+		return XST_INVALID_PARAM;
+	UINTPTR sep = (sizeof(XAxiDma_Bd) + (Alignment - 1)) & ~(UINTPTR)(Alignment - 1);
+
+	RingPtr->AllCnt = 0;
+	RingPtr->FreeCnt = 0;
+	RingPtr->HwCnt = 0;
+	RingPtr->PreCnt = 0;
+	RingPtr->PostCnt = 0;
+	RingPtr->Cyclic = 0;
+
+	memset((void*)VirtAddr, 0, BdCount * sep);
+	UINTPTR bdVirt = VirtAddr;
+	UINTPTR bdPhysNext = PhysAddr + sep;
+	for (int ix = 1; ix < BdCount; ++ix){
+		XAxiDma_BdWrite(bdVirt, XAXIDMA_BD_NDESC_OFFSET, (u32)bdPhysNext);
+		XAxiDma_BdWrite(bdVirt, XAXIDMA_BD_NDESC_MSB_OFFSET, (u32)((u64)bdPhysNext >> 32));
+		XAxiDma_BdWrite(bdVirt, XAXIDMA_BD_HAS_STSCNTRL_OFFSET, RingPtr->HasStsCntrlStrm);
+		XAxiDma_BdWrite(bdVirt, XAXIDMA_BD_HAS_DRE_OFFSET, RingPtr->HasDRE << 8 | RingPtr->DataWidth);
+		bdVirt += sep;
+		bdPhysNext += sep;
+	}
+	// last BD links back to the first one
+	XAxiDma_BdWrite(bdVirt, XAXIDMA_BD_NDESC_OFFSET, (u32)PhysAddr);
+	XAxiDma_BdWrite(bdVirt, XAXIDMA_BD_NDESC_MSB_OFFSET, (u32)((u64)PhysAddr >> 32));
+	XAxiDma_BdWrite(bdVirt, XAXIDMA_BD_HAS_STSCNTRL_OFFSET, RingPtr->HasStsCntrlStrm);
+	XAxiDma_BdWrite(bdVirt, XAXIDMA_BD_HAS_DRE_OFFSET, RingPtr->HasDRE << 8 | RingPtr->DataWidth);
+
+	RingPtr->RunState = AXIDMA_CHANNEL_HALTED;
+	RingPtr->FirstBdAddr = VirtAddr;
+	RingPtr->FirstBdPhysAddr = PhysAddr;
+	RingPtr->LastBdAddr = bdVirt;
+	RingPtr->Length = RingPtr->LastBdAddr - RingPtr->FirstBdAddr + sep;
+	RingPtr->Separation = sep;
+	RingPtr->AllCnt = BdCount;
+	RingPtr->FreeCnt = BdCount;
+	RingPtr->FreeHead = (XAxiDma_Bd*)VirtAddr;
+	RingPtr->PreHead = (XAxiDma_Bd*)VirtAddr;
+	RingPtr->HwHead = (XAxiDma_Bd*)VirtAddr;
+	RingPtr->HwTail = (XAxiDma_Bd*)VirtAddr;
+	RingPtr->PostHead = (XAxiDma_Bd*)VirtAddr;
+	RingPtr->BdaRestart = (XAxiDma_Bd*)PhysAddr;
+	return XST_SUCCESS;
+}
+
+int XAxiDma_BdRingClone(XAxiDma_BdRing *RingPtr, XAxiDma_Bd *SrcBdPtr){
+	if (RingPtr->AllCnt == 0)
+		return XST_DMA_SG_LIST_ERROR;
+	if (RingPtr->FreeCnt != RingPtr->AllCnt)
+		return XST_DMA_SG_LIST_ERROR; // can only clone an idle ring
+	if (RingPtr->RunState == AXIDMA_CHANNEL_NOT_HALTED)
+		return XST_DMA_SG_LIST_ERROR;
+
+	XAxiDma_Bd tmp;
+	memcpy(&tmp, SrcBdPtr, sizeof(tmp));
+	XAxiDma_BdWrite(&tmp, XAXIDMA_BD_STS_OFFSET, 0);
+	UINTPTR bd = RingPtr->FirstBdAddr;
+	for (int ix = 0; ix < RingPtr->AllCnt; ++ix, bd += RingPtr->Separation){
+		// keep link and hardware-feature words
+		u32 nd = XAxiDma_BdRead(bd, XAXIDMA_BD_NDESC_OFFSET);
+		u32 ndMsb = XAxiDma_BdRead(bd, XAXIDMA_BD_NDESC_MSB_OFFSET);
+		u32 hasSts = XAxiDma_BdRead(bd, XAXIDMA_BD_HAS_STSCNTRL_OFFSET);
+		u32 hasDre = XAxiDma_BdRead(bd, XAXIDMA_BD_HAS_DRE_OFFSET);
+		memcpy((void*)bd, &tmp, sizeof(tmp));
+		XAxiDma_BdWrite(bd, XAXIDMA_BD_NDESC_OFFSET, nd);
+		XAxiDma_BdWrite(bd, XAXIDMA_BD_NDESC_MSB_OFFSET, ndMsb);
+		XAxiDma_BdWrite(bd, XAXIDMA_BD_HAS_STSCNTRL_OFFSET, hasSts);
+		XAxiDma_BdWrite(bd, XAXIDMA_BD_HAS_DRE_OFFSET, hasDre);
+	}
+	return XST_SUCCESS;
+}
+
+int XAxiDma_BdRingAlloc(XAxiDma_BdRing *RingPtr, int NumBd, XAxiDma_Bd **BdSetPtr){
+	if (NumBd <= 0)
+		return XST_INVALID_PARAM;
+	if (RingPtr->FreeCnt < NumBd)
+		return XST_FAILURE;
+	*BdSetPtr = RingPtr->FreeHead;
+	RingPtr->FreeHead = bdAdvance(RingPtr, RingPtr->FreeHead, NumBd);
+	RingPtr->FreeCnt -= NumBd;
+	RingPtr->PreCnt += NumBd;
+	return XST_SUCCESS;
+}
+
+int XAxiDma_BdRingUnAlloc(XAxiDma_BdRing *RingPtr, int NumBd, XAxiDma_Bd *BdSetPtr){
+	(void)BdSetPtr;
+	if (NumBd <= 0)
+		return XST_INVALID_PARAM;
+	if (RingPtr->PreCnt < NumBd)
+		return XST_FAILURE;
+	RingPtr->FreeHead = bdAdvance(RingPtr, RingPtr->FreeHead, RingPtr->AllCnt - NumBd);
+	RingPtr->FreeCnt += NumBd;
+	RingPtr->PreCnt -= NumBd;
+	return XST_SUCCESS;
+}
+
+int XAxiDma_BdRingToHw(XAxiDma_BdRing *RingPtr, int NumBd, XAxiDma_Bd *BdSetPtr){
+	if (NumBd < 0)
+		return XST_INVALID_PARAM;
+	if (NumBd == 0)
+		return XST_SUCCESS;
+	if ((RingPtr->PreCnt < NumBd) || (RingPtr->PreHead != BdSetPtr))
+		return XST_DMA_SG_LIST_ERROR;
+
+	XAxiDma_Bd* bd = BdSetPtr;
+	// like the driver: a Tx set must start with SOF and end with EOF
+	if (!RingPtr->IsRxChannel && !(XAxiDma_BdGetCtrl(bd) & XAXIDMA_BD_CTRL_TXSOF_MASK))
+		return XST_FAILURE;
+	for (int ix = 0; ix < NumBd; ++ix){
+		if (!(XAxiDma_BdGetLength(bd, RingPtr->MaxTransferLen)))
+			return XST_INVALID_PARAM;
+		XAxiDma_BdWrite(bd, XAXIDMA_BD_STS_OFFSET, 0);
+		if (ix < NumBd - 1)
+			bd = (XAxiDma_Bd*)XAxiDma_BdRingNext(RingPtr, bd);
+	}
+	if (!RingPtr->IsRxChannel && !(XAxiDma_BdGetCtrl(bd) & XAXIDMA_BD_CTRL_TXEOF_MASK))
+		return XST_FAILURE;
+
+	RingPtr->PreHead = bdAdvance(RingPtr, RingPtr->PreHead, NumBd);
+	RingPtr->PreCnt -= NumBd;
+	RingPtr->HwTail = bd;
+	RingPtr->HwCnt += NumBd;
+
+	if (RingPtr->RunState == AXIDMA_CHANNEL_NOT_HALTED){
+		hostDmaChannel* ch = chan(RingPtr);
+		std::lock_guard<std::mutex> lk(ch->engine->m);
+		ch->engine->writeTail(*queue(RingPtr), bdPhys(RingPtr, bd));
+	}
+	return XST_SUCCESS;
+}
+
+int XAxiDma_BdRingFromHw(XAxiDma_BdRing *RingPtr, int BdLimit, XAxiDma_Bd **BdSetPtr){
+	XAxiDma_Bd* bd = RingPtr->HwHead;
+	int bdCount = 0;
+	int bdPartialCount = 0;
+	while ((bdCount < BdLimit) && (bdCount < RingPtr->HwCnt)){
+		u32 sts = __atomic_load_n((u32*)((UINTPTR)bd + XAXIDMA_BD_STS_OFFSET), __ATOMIC_ACQUIRE);
+		if (!(sts & XAXIDMA_BD_STS_COMPLETE_MASK))
+			break;
+		++bdCount;
+
+		// only whole packets are returned
+		bool eop = RingPtr->IsRxChannel ? (sts & XAXIDMA_BD_STS_RXEOF_MASK) : (XAxiDma_BdGetCtrl(bd) & XAXIDMA_BD_CTRL_TXEOF_MASK);
+		if (eop)
+			bdPartialCount = 0;
+		else
+			++bdPartialCount;
+
+		if (bd == RingPtr->HwTail)
+			break;
+		bd = (XAxiDma_Bd*)XAxiDma_BdRingNext(RingPtr, bd);
+	}
+	bdCount -= bdPartialCount;
+
+	if (bdCount > 0){
+		*BdSetPtr = RingPtr->HwHead;
+		RingPtr->HwCnt -= bdCount;
+		RingPtr->PostCnt += bdCount;
+		RingPtr->HwHead = bdAdvance(RingPtr, RingPtr->HwHead, bdCount);
+		return bdCount;
+	}
+	*BdSetPtr = NULL;
+	return 0;
+}
+
+int XAxiDma_BdRingFree(XAxiDma_BdRing *RingPtr, int NumBd, XAxiDma_Bd *BdSetPtr){
+	if (NumBd < 0)
+		return XST_INVALID_PARAM;
+	if (NumBd == 0)
+		return XST_SUCCESS;
+	if ((RingPtr->PostCnt < NumBd) || (RingPtr->PostHead != BdSetPtr))
+		return XST_DMA_SG_LIST_ERROR;
+	RingPtr->PostHead = bdAdvance(RingPtr, RingPtr->PostHead, NumBd);
+	RingPtr->PostCnt -= NumBd;
+	RingPtr->FreeCnt += NumBd;
+	return XST_SUCCESS;
+}
+
+int XAxiDma_BdRingStart(XAxiDma_BdRing *RingPtr){
+	hostDmaChannel* ch = chan(RingPtr);
+	std::lock_guard<std::mutex> lk(ch->engine->m);
+	hostDmaQueue* q = queue(RingPtr);
+	ch->engine->start(*q, bdPhys(RingPtr, RingPtr->HwHead));
+	RingPtr->RunState = AXIDMA_CHANNEL_NOT_HALTED;
+	if (RingPtr->HwCnt > 0)
+		ch->engine->writeTail(*q, bdPhys(RingPtr, RingPtr->HwTail));
+	return XST_SUCCESS;
+}
+
+int XAxiDma_BdRingEnableCyclicDMA(XAxiDma_BdRing *RingPtr){
+	// driver bookkeeping only, the mode itself is a channel register (XAxiDma_SelectCyclicMode())
+	RingPtr->Cyclic = 1;
+	return XST_SUCCESS;
+}
+
+int XAxiDma_BdRingSetCoalesce(XAxiDma_BdRing *RingPtr, u32 Counter, u32 Timer){
+	if ((Counter != XAXIDMA_NO_CHANGE) && ((Counter == 0) || (Counter > XAXIDMA_COALESCE_MAX)))
+		return XST_FAILURE;
+	if ((Timer != XAXIDMA_NO_CHANGE) && (Timer > XAXIDMA_DELAY_MAX))
+		return XST_FAILURE;
+	hostDmaChannel* ch = chan(RingPtr);
+	std::lock_guard<std::mutex> lk(ch->engine->m);
+	if (Counter != XAXIDMA_NO_CHANGE)
+		ch->irqThreshold = ch->thresholdCount = Counter;
+	if (Timer != XAXIDMA_NO_CHANGE)
+		ch->irqDelay = Timer;
+	return XST_SUCCESS;
+}
+
+void XAxiDma_BdRingGetCoalesce(XAxiDma_BdRing *RingPtr, u32 *CounterPtr, u32 *TimerPtr){
+	hostDmaChannel* ch = chan(RingPtr);
+	std::lock_guard<std::mutex> lk(ch->engine->m);
+	*CounterPtr = ch->irqThreshold;
+	*TimerPtr = ch->irqDelay;
+}
+
+void XAxiDma_BdRingIntEnable(XAxiDma_BdRing *RingPtr, u32 Mask){
+	hostDmaChannel* ch = chan(RingPtr);
+	std::lock_guard<std::mutex> lk(ch->engine->m);
+	ch->irqEnable |= (Mask & XAXIDMA_IRQ_ALL_MASK);
+	if (ch->irqStatus & ch->irqEnable)
+		XHost_RaiseInterrupt(ch->irqId);
+}
+
+void XAxiDma_BdRingIntDisable(XAxiDma_BdRing *RingPtr, u32 Mask){
+	hostDmaChannel* ch = chan(RingPtr);
+	std::lock_guard<std::mutex> lk(ch->engine->m);
+	ch->irqEnable &= ~(Mask & XAXIDMA_IRQ_ALL_MASK);
+}
+
+u32 XAxiDma_BdRingGetIrq(XAxiDma_BdRing *RingPtr){
+	hostDmaChannel* ch = chan(RingPtr);
+	std::lock_guard<std::mutex> lk(ch->engine->m);
+	return ch->irqStatus & XAXIDMA_IRQ_ALL_MASK;
+}
+
+void XAxiDma_BdRingAckIrq(XAxiDma_BdRing *RingPtr, u32 Mask){
+	hostDmaChannel* ch = chan(RingPtr);
+	std::lock_guard<std::mutex> lk(ch->engine->m);
+	ch->irqStatus &= ~(Mask & XAXIDMA_IRQ_ALL_MASK);
+}
@@ -0,0 +1,27 @@
+#ifndef XAXIDMA_HW_H
+#define XAXIDMA_HW_H
+// host (Linux) stand-in for the Xilinx AXI DMA driver header of the same name
+// Channel registers at XAxiDma_BdRing::ChanBase. The model decodes DMACR and DMASR only; a DMACR write may change RS alone.
+#include "xil_types.h"
+
+// === channel register offsets ===
+#define XAXIDMA_CR_OFFSET 0x00000000
+#define XAXIDMA_SR_OFFSET 0x00000004
+
+// === DMACR ===
+#define XAXIDMA_CR_RUNSTOP_MASK 0x00000001
+#define XAXIDMA_CR_RESET_MASK 0x00000004
+#define XAXIDMA_CR_CYCLIC_MASK 0x00000010
+#define XAXIDMA_COALESCE_MASK 0x00FF0000
+#define XAXIDMA_DELAY_MASK 0xFF000000
+#define XAXIDMA_COALESCE_SHIFT 16
+#define XAXIDMA_DELAY_SHIFT 24
+
+// === DMASR ===
+#define XAXIDMA_HALTED_MASK 0x00000001
+#define XAXIDMA_IDLE_MASK 0x00000002
+
+// the driver maps these to Xil_In32() / Xil_Out32()
+u32 XAxiDma_ReadReg(UINTPTR BaseAddress, u32 RegOffset);
+void XAxiDma_WriteReg(UINTPTR BaseAddress, u32 RegOffset, u32 Data);
+#endif
@@ -0,0 +1,32 @@
+#ifndef XHOST_MODEL_H
+#define XHOST_MODEL_H
+// Controls of the host software model that have no counterpart in the board BSP.
+// Application code uses these only under #ifdef XHOST_MODEL.
+#include "xil_types.h"
+
+// === interrupt controller ===
+// asserts interrupt line Int_Id (rising edge) on the simulated GIC. Used by the device models.
+void XHost_RaiseInterrupt(u32 Int_Id);
+
+// === AXI DMA loopback ===
+// depth of the AXI-Stream FIFO between MM2S and S2MM (default 32 KiB). Takes effect on the next reset of the FIFO: any
+// XAxiDma_Reset() / CfgInitialize() while it is empty, see also XHost_AxiDmaSetFifoResetOnDmaReset().
+void XHost_AxiDmaSetFifoDepth(u32 DeviceId, u32 NumBytes);
+
+// Enable: the FIFO reset is wired to the DMA's s2mm_prmry_reset_out_n => XAxiDma_Reset() also drops data in the FIFO.
+// Default (0): the FIFO is on the system reset only and keeps its contents, S2MM receives them after the DMA reset
+void XHost_AxiDmaSetFifoResetOnDmaReset(u32 DeviceId, int Enable);
+
+// the NumBds-th BD processed from now on the given channel fails with a slave error (DMA error interrupt, channel halts)
+// 0 disables injection
+void XHost_AxiDmaInjectError(u32 DeviceId, int IsRx, u32 NumBds);
+
+// external AXI-Stream source into the S2MM side of the FIFO (e.g. acquisition data without using MM2S)
+// returns the number of bytes accepted (limited by FIFO space). Tlast marks the end of a packet once all bytes were accepted.
+// Tdest selects the S2MM channel of a multichannel DMA; it is taken from the first write of each packet.
+u32 XHost_AxiDmaStreamWrite(u32 DeviceId, const void *Data, u32 NumBytes, int Tlast, u32 Tdest = 0);
+
+// external AXI-Stream sink from the MM2S side of the FIFO (e.g. playout without using S2MM, which must not run meanwhile)
+// returns the number of bytes read (limited by FIFO content), stopping at the end of a packet. *Tlast (if given) reports it.
+u32 XHost_AxiDmaStreamRead(u32 DeviceId, void *Data, u32 NumBytes, int *Tlast = NULL);
+#endif
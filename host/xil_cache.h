@@ -0,0 +1,11 @@
+#ifndef XIL_CACHE_H
+#define XIL_CACHE_H
+// host (Linux) stand-in for the Xilinx standalone BSP header of the same name
+// The software DMA model shares the CPU's coherent view of memory => cache maintenance is a no-op.
+#include "xil_types.h"
+
+static inline void Xil_DCacheFlushRange(INTPTR adr, INTPTR len){ (void)adr; (void)len; }
+static inline void Xil_DCacheInvalidateRange(INTPTR adr, INTPTR len){ (void)adr; (void)len; }
+static inline void Xil_DCacheFlush(void){}
+static inline void Xil_DCacheInvalidate(void){}
+#endif
@@ -0,0 +1,20 @@
+#ifndef XIL_EXCEPTION_H
+#define XIL_EXCEPTION_H
+// host (Linux) stand-in for the Xilinx standalone BSP header of the same name
+// "The CPU" is modelled by a dispatcher thread (see xscugic_host.cpp) that runs the registered IRQ exception handler.
+// Xil_ExceptionDisable() blocks until a running handler returns and holds off further ones until Xil_ExceptionEnable()
+// => the same critical sections that protect application code from the ISR on the board work on the host.
+#include "xil_types.h"
+
+#define XIL_EXCEPTION_ID_INT 5U
+#define XIL_EXCEPTION_ID_IRQ_INT XIL_EXCEPTION_ID_INT
+
+typedef void (*Xil_ExceptionHandler)(void *data);
+typedef void (*Xil_InterruptHandler)(void *data);
+
+void Xil_ExceptionInit(void);
+void Xil_ExceptionRegisterHandler(u32 Exception_id, Xil_ExceptionHandler Handler, void *Data);
+void Xil_ExceptionRemoveHandler(u32 Exception_id);
+void Xil_ExceptionEnable(void);
+void Xil_ExceptionDisable(void);
+#endif
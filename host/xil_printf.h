@@ -0,0 +1,5 @@
+#ifndef XIL_PRINTF_H
+#define XIL_PRINTF_H
+// host (Linux) stand-in for the Xilinx standalone BSP header of the same name
+void xil_printf(const char *format, ...);
+#endif
@@ -0,0 +1,22 @@
+#ifndef XIL_TYPES_H
+#define XIL_TYPES_H
+// host (Linux) stand-in for the Xilinx standalone BSP header of the same name
+#include <stdint.h>
+#include <stddef.h>
+
+// identifies a build against the host software model instead of the board BSP
+#define XHOST_MODEL
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int32_t s32;
+typedef uintptr_t UINTPTR;
+typedef intptr_t INTPTR;
+
+typedef void (*XInterruptHandler)(void *InstancePtr);
+typedef void (*XExceptionHandler)(void *InstancePtr);
+
+#define XIL_COMPONENT_IS_READY 0x11111111U
+#endif
@@ -0,0 +1,35 @@
+#ifndef XPARAMETERS_H
+#define XPARAMETERS_H
+// host (Linux) stand-in for the generated hardware parameters of the reference block design:
+// AXI DMA with SG, MM2S looped back to S2MM through an AXI-Stream FIFO, interrupts routed to the GIC via concat
+// AXIDMA_4 is built with multichannel support: 4 S2MM channels, demultiplexed by TDEST
+#include "xil_types.h"
+
+#define XPAR_XAXIDMA_NUM_INSTANCES 5U
+
+#define XPAR_AXIDMA_0_DEVICE_ID 0U
+#define XPAR_AXIDMA_1_DEVICE_ID 1U
+#define XPAR_AXIDMA_2_DEVICE_ID 2U
+#define XPAR_AXIDMA_3_DEVICE_ID 3U
+#define XPAR_AXIDMA_4_DEVICE_ID 4U
+#define XPAR_AXIDMA_0_NUM_S2MM_CHANNELS 1U
+#define XPAR_AXIDMA_1_NUM_S2MM_CHANNELS 1U
+#define XPAR_AXIDMA_2_NUM_S2MM_CHANNELS 1U
+#define XPAR_AXIDMA_3_NUM_S2MM_CHANNELS 1U
+#define XPAR_AXIDMA_4_NUM_S2MM_CHANNELS 4U
+#define XPAR_AXI_DMA_0_SG_LENGTH_WIDTH 23U
+
+#define XPAR_SCUGIC_SINGLE_DEVICE_ID 0U
+#define XPAR_SCUGIC_NUM_INSTANCES 1U
+
+#define XPAR_FABRIC_AXIDMA_0_MM2S_INTROUT_VEC_ID 61U
+#define XPAR_FABRIC_AXIDMA_0_S2MM_INTROUT_VEC_ID 62U
+#define XPAR_FABRIC_AXIDMA_1_MM2S_INTROUT_VEC_ID 63U
+#define XPAR_FABRIC_AXIDMA_1_S2MM_INTROUT_VEC_ID 64U
+#define XPAR_FABRIC_AXIDMA_2_MM2S_INTROUT_VEC_ID 65U
+#define XPAR_FABRIC_AXIDMA_2_S2MM_INTROUT_VEC_ID 66U
+#define XPAR_FABRIC_AXIDMA_3_MM2S_INTROUT_VEC_ID 67U
+#define XPAR_FABRIC_AXIDMA_3_S2MM_INTROUT_VEC_ID 68U
+#define XPAR_FABRIC_AXIDMA_4_MM2S_INTROUT_VEC_ID 69U
+#define XPAR_FABRIC_AXIDMA_4_S2MM_INTROUT_VEC_ID 70U
+#endif
@@ -0,0 +1,230 @@
+// host software model: interrupt controller, CPU exception masking, time base, console
+#include "xscugic.h"
+#include "xtime_l.h"
+#include "xil_printf.h"
+#include "xparameters.h"
+#include "xhost_model.h"
+
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <cstdio>
+#include <cstdarg>
+
+namespace {
+// GIC distributor and the single "CPU" that takes IRQ exceptions
+struct hostGic{
+	std::mutex m;
+	std::condition_variable cv;
+
+	// distributor state
+	bool enabled[XSCUGIC_MAX_NUM_INTR_INPUTS] = {};
+	bool pending[XSCUGIC_MAX_NUM_INTR_INPUTS] = {};
+	u8 priority[XSCUGIC_MAX_NUM_INTR_INPUTS] = {};
+
+	// CPU state: IRQs are masked out of reset until Xil_ExceptionEnable()
+	bool masked = true;
+	// dispatcher thread is executing the exception handler
+	bool inHandler = false;
+	Xil_ExceptionHandler irqHandler = NULL;
+	void* irqData = NULL;
+
+	std::thread::id dispatcherId;
+
+	hostGic(){
+		std::thread t([this]{dispatch();});
+		dispatcherId = t.get_id();
+		t.detach(); // lives for the whole process, like the CPU
+	}
+
+	// returns the highest-priority (lowest value) deliverable interrupt, or -1 (call with m held)
+	int nextPending() const{
+		int best = -1;
+		for (u32 id = 0; id < XSCUGIC_MAX_NUM_INTR_INPUTS; ++id)
+			if (pending[id] && enabled[id] && ((best < 0) || (priority[id] < priority[best])))
+				best = (int)id;
+		return best;
+	}
+
+	void dispatch(){
+		std::unique_lock<std::mutex> lk(m);
+		while (true){
+			cv.wait(lk, [this]{return !masked && irqHandler && (nextPending() >= 0);});
+			inHandler = true;
+			Xil_ExceptionHandler h = irqHandler;
+			void* d = irqData;
+			lk.unlock();
+			h(d);
+			lk.lock();
+			inHandler = false;
+			cv.notify_all();
+		}
+	}
+
+	bool isDispatcher() const{
+		return std::this_thread::get_id() == dispatcherId;
+	}
+};
+
+hostGic& gic(){
+	static hostGic* g = new hostGic(); // never destroyed: interrupts may still arrive during static destruction
+	return *g;
+}
+
+XScuGic_Config configTable[XPAR_SCUGIC_NUM_INSTANCES] = {{/*DeviceId*/XPAR_SCUGIC_SINGLE_DEVICE_ID, /*CpuBaseAddress*/0xF8F00100, /*DistBaseAddress*/0xF8F01000, {}}};
+
+void stubHandler(void* CallBackRef){
+	XScuGic* InstancePtr = (XScuGic*)CallBackRef;
+	++InstancePtr->UnhandledInterrupts;
+}
+} // namespace
+
+void XHost_RaiseInterrupt(u32 Int_Id){
+	if (Int_Id >= XSCUGIC_MAX_NUM_INTR_INPUTS)
+		return;
+	hostGic& g = gic();
+	std::lock_guard<std::mutex> lk(g.m);
+	g.pending[Int_Id] = true;
+	g.cv.notify_all();
+}
+
+// === xil_exception ===
+void Xil_ExceptionInit(void){}
+
+void Xil_ExceptionRegisterHandler(u32 Exception_id, Xil_ExceptionHandler Handler, void *Data){
+	if (Exception_id != XIL_EXCEPTION_ID_INT)
+		return; // only IRQ is modelled
+	hostGic& g = gic();
+	std::lock_guard<std::mutex> lk(g.m);
+	g.irqHandler = Handler;
+	g.irqData = Data;
+	g.cv.notify_all();
+}
+
+void Xil_ExceptionRemoveHandler(u32 Exception_id){
+	Xil_ExceptionRegisterHandler(Exception_id, NULL, NULL);
+}
+
+void Xil_ExceptionEnable(void){
+	hostGic& g = gic();
+	if (g.isDispatcher())
+		return; // handlers run with IRQs masked; no nesting
+	std::lock_guard<std::mutex> lk(g.m);
+	g.masked = false;
+	g.cv.notify_all();
+}
+
+void Xil_ExceptionDisable(void){
+	hostGic& g = gic();
+	if (g.isDispatcher())
+		return; // already masked inside the handler
+	std::unique_lock<std::mutex> lk(g.m);
+	// a handler that is already running must complete first, as if it had preempted the caller
+	g.cv.wait(lk, [&g]{return !g.inHandler;});
+	g.masked = true;
+}
+
+// === xscugic ===
+XScuGic_Config *XScuGic_LookupConfig(u16 DeviceId){
+	for (u32 ix = 0; ix < XPAR_SCUGIC_NUM_INSTANCES; ++ix)
+		if (configTable[ix].DeviceId == DeviceId)
+			return &configTable[ix];
+	return NULL;
+}
+
+s32 XScuGic_CfgInitialize(XScuGic *InstancePtr, XScuGic_Config *ConfigPtr, u32 EffectiveAddr){
+	(void)EffectiveAddr;
+	InstancePtr->IsReady = 0;
+	InstancePtr->Config = ConfigPtr;
+	for (u32 id = 0; id < XSCUGIC_MAX_NUM_INTR_INPUTS; ++id)
+		if (!ConfigPtr->HandlerTable[id].Handler){
+			ConfigPtr->HandlerTable[id].Handler = stubHandler;
+			ConfigPtr->HandlerTable[id].CallBackRef = InstancePtr;
+		}
+
+	// distributor init: like the hardware, this disables and clears all interrupt sources
+	hostGic& g = gic();
+	{
+		std::lock_guard<std::mutex> lk(g.m);
+		for (u32 id = 0; id < XSCUGIC_MAX_NUM_INTR_INPUTS; ++id){
+			g.enabled[id] = false;
+			g.pending[id] = false;
+			g.priority[id] = 0xA0;
+		}
+	}
+	InstancePtr->IsReady = XIL_COMPONENT_IS_READY;
+	return XST_SUCCESS;
+}
+
+s32 XScuGic_Connect(XScuGic *InstancePtr, u32 Int_Id, Xil_InterruptHandler Handler, void *CallBackRef){
+	if ((Int_Id >= XSCUGIC_MAX_NUM_INTR_INPUTS) || !Handler)
+		return XST_INVALID_PARAM;
+	InstancePtr->Config->HandlerTable[Int_Id].Handler = Handler;
+	InstancePtr->Config->HandlerTable[Int_Id].CallBackRef = CallBackRef;
+	return XST_SUCCESS;
+}
+
+void XScuGic_Disconnect(XScuGic *InstancePtr, u32 Int_Id){
+	XScuGic_Disable(InstancePtr, Int_Id);
+	InstancePtr->Config->HandlerTable[Int_Id].Handler = stubHandler;
+	InstancePtr->Config->HandlerTable[Int_Id].CallBackRef = InstancePtr;
+}
+
+void XScuGic_Enable(XScuGic *InstancePtr, u32 Int_Id){
+	(void)InstancePtr;
+	hostGic& g = gic();
+	std::lock_guard<std::mutex> lk(g.m);
+	g.enabled[Int_Id] = true;
+	g.cv.notify_all();
+}
+
+void XScuGic_Disable(XScuGic *InstancePtr, u32 Int_Id){
+	(void)InstancePtr;
+	hostGic& g = gic();
+	std::lock_guard<std::mutex> lk(g.m);
+	g.enabled[Int_Id] = false;
+}
+
+void XScuGic_SetPriorityTriggerType(XScuGic *InstancePtr, u32 Int_Id, u8 Priority, u8 Trigger){
+	(void)InstancePtr;
+	(void)Trigger; // the device models raise edges only
+	hostGic& g = gic();
+	std::lock_guard<std::mutex> lk(g.m);
+	g.priority[Int_Id] = Priority;
+}
+
+void XScuGic_InterruptMaptoCpu(XScuGic *InstancePtr, u8 Cpu_Identifier, u32 Int_Id){
+	// one "CPU" (the dispatcher thread) takes all interrupts
+	(void)InstancePtr;
+	(void)Cpu_Identifier;
+	(void)Int_Id;
+}
+
+void XScuGic_InterruptHandler(XScuGic *InstancePtr){
+	// acknowledge one interrupt (IAR read), then call its handler. Dispatcher re-enters for further pending IDs
+	hostGic& g = gic();
+	int id;
+	{
+		std::lock_guard<std::mutex> lk(g.m);
+		id = g.nextPending();
+		if (id < 0)
+			return; // spurious
+		g.pending[id] = false;
+	}
+	XScuGic_VectorTableEntry* e = &InstancePtr->Config->HandlerTable[id];
+	e->Handler(e->CallBackRef);
+}
+
+// === xtime_l ===
+void XTime_GetTime(XTime *Xtime_Global){
+	*Xtime_Global = (XTime)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// === xil_printf ===
+void xil_printf(const char *format, ...){
+	va_list args;
+	va_start(args, format);
+	vprintf(format, args);
+	va_end(args);
+}
@@ -0,0 +1,10 @@
+#ifndef XSTATUS_H
+#define XSTATUS_H
+// host (Linux) stand-in for the Xilinx standalone BSP header of the same name
+#define XST_SUCCESS 0L
+#define XST_FAILURE 1L
+#define XST_DEVICE_NOT_FOUND 2L
+#define XST_INVALID_PARAM 15L
+#define XST_DMA_SG_LIST_ERROR 533L
+#define XST_DMA_SG_COUNT_EXCEEDED 511L
+#endif
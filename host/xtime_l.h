@@ -0,0 +1,12 @@
+#ifndef XTIME_L_H
+#define XTIME_L_H
+// host (Linux) stand-in for the Xilinx standalone BSP header of the same name
+#include "xil_types.h"
+
+typedef u64 XTime;
+
+// host time base is CLOCK_MONOTONIC in nanoseconds
+#define COUNTS_PER_SECOND 1000000000ULL
+
+void XTime_GetTime(XTime *Xtime_Global);
+#endif
@@ -1,7 +1,932 @@
 #include "xtime_l.h" // for throughput calculation
 #include <stdio.h> // using full-featured printf (large!)
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
 
 #include "dmaFeedBasic.h"
+#include "dmaFeedJobs.h"
+#include "dmaFeedStream.h"
+#include "dmaFeedCyclic.h"
+#include "dmaFeedPipe.h"
+#include "dmaBufferPool.h"
+#include "dmaServiceCore.h"
+#ifdef XHOST_MODEL
+#	include "xhost_model.h" // stream source / sink for the cyclic capture and single direction benchmarks, error injection
+#	include <thread> // service core benchmark
+#endif
+
+// === benchmark sweep ===
+// every combination of the lists below is one benchmark case (see skipCase() for excluded combinations)
+// Build with -DDMAFEED_STATS=1 to report interrupt counts and time in interrupt callbacks, otherwise those columns are 0.
+// Build with -DDMAFEED_TRACE=1 to append a dmaTrace dump of the last events.
+static const u32 sweepMaxPacketSize[] = {8192, 2048, 512, 128, 32, 8};
+static const u32 sweepNBytes[] = {64 << 10, 1 << 20, 16 << 20};
+static const u32 sweepNBytesAllocBd[] = {0x4000, 0x10000, 0}; // per ring. 0: dmaFeedBaseConfig::sizeRings()
+static const u32 sweepCoalesceN[] = {1, 8};
+static const u32 sweepCoalesceDelay[] = {0, 16};
+static const bool sweepCoalesceAdaptive[] = {false, true}; // adaptive: coalesceN / coalesceDelay are the starting point
+static const dmaFeedBaseConfig::completion_e sweepCompletionMode[] = {dmaFeedBaseConfig::DMAFEED_COMPLETION_IRQ, dmaFeedBaseConfig::DMAFEED_COMPLETION_POLL, dmaFeedBaseConfig::DMAFEED_COMPLETION_HYBRID, dmaFeedBaseConfig::DMAFEED_COMPLETION_DEFERRED};
+static const char* const completionModeName[] = {"irq", "poll", "hybrid", "deferred"}; // indexed by completion_e
+
+// untimed runs per case before measurement
+static const unsigned int nWarmupRuns = 1;
+// timed runs per case
+static const unsigned int nRuns = 9;
+// cases needing more BDs than this are skipped (keeps small-packet cases at a sensible run time)
+static const u32 maxBdsPerRun = 1 << 17;
+
+// === job queue benchmark ===
+// nJobsPerRun back-to-back transfers of each size: dmaFeedBasic (one runStart() / run_poll() cycle per job) vs. dmaFeedJobs (submission queue)
+static const u32 sweepJobSize[] = {4 << 10, 16 << 10, 64 << 10};
+static const unsigned int nJobsPerRun = 256;
+
+#ifdef XHOST_MODEL
+// === service core benchmark (host model only: service core as a thread) ===
+// the job queue benchmark through dmaServiceCore, run() in a thread of its own, vs. dmaFeedJobs serviced by the submitting thread
+static const unsigned int serviceCoreNRequests = 64;
+#endif
+
+// === replay benchmark ===
+// nJobsPerRun repetitions of the same transfer: runStart() (BDs programmed each time) vs. runReplay() (dmaFeedBasicConfig::replay)
+static const u32 sweepReplayNBytes[] = {4 << 10, 16 << 10, 64 << 10};
+static const u32 replayMaxPacketSize = 512;
+
+// === variable-length Rx benchmark ===
+// nJobsPerRun transactions that receive a Tx packet of eofPacketSize bytes into eofCapacity bytes of Rx buffer
+// (dmaFeedBasicConfig::rxCompleteOnEof). Burst: each transaction sends eofNBurst packets, the ones after the first land in
+// the Rx BDs left armed (=> reset). Single: one packet per transaction, the same Rx buffer each time (=> armed BDs retired).
+// Consecutive: one packet per transaction, each Rx range starts where the last packet ended (getRxBytesConsumed()) => the
+// armed BDs are adopted
+static const u32 eofPacketSize = 4 << 10;
+static const u32 eofMaxPacketSize = 1024; // Tx ring of eofPacketSize / eofMaxPacketSize BDs => every Tx packet fills it
+static const u32 eofCapacity = 64 << 10;
+static const unsigned int eofNBurst = 4;
+
+// === BD fill benchmark ===
+// small packets, where the per-BD cost limits throughput: one driver call per BD field vs. dmaBdTemplate (dmaFeedBasicConfig::fastBdFill)
+static const u32 sweepBdFillPacketSize[] = {8, 32, 128};
+static const u32 bdFillNBytes = 64 << 10;
+
+// === interrupt dispatch benchmark ===
+// no coalescing, small packets: interrupt callbacks through the vtable vs. specialized for dmaFeedBasic
+// (dmaFeedBasicConfig::inlineIsr)
+static const u32 sweepDispatchPacketSize[] = {8, 32, 128};
+static const u32 dispatchNBytes = 16 << 10;
+
+#ifdef XHOST_MODEL
+// === cyclic capture benchmark (host model only: needs an AXI-Stream source, XHost_AxiDmaStreamWrite()) ===
+// cyclicNBytes from the source, one packet per buffer, into dmaFeedStream (every buffer collected and re-armed) vs. dmaFeedCyclic
+static const u32 cyclicNBuffers = 16;
+static const u32 cyclicBufferSize = 4 << 10;
+static const u32 cyclicNBytes = 1 << 20;
+#endif
+
+#ifdef XHOST_MODEL
+// === error recovery benchmark (host model only: needs XHost_AxiDmaInjectError()) ===
+// one Tx DMA error per run at BD errorAtBd: the application restarts the whole transfer vs. run_poll() resumes it
+// (dmaFeedBasicConfig::resumeMaxRetries)
+static const u32 sweepErrorAtBd[] = {64, 256, 448};
+static const u32 recoveryNBytes = 4 << 20;
+static const u32 recoveryMaxPacketSize = 8192; // 512 BDs
+#endif
+
+// === pipe benchmark ===
+// the largest sweepNBytes transfer from / to memory (dmaFeedBasic: both buffers materialized and verified after the run) vs.
+// produced and consumed on the fly by dmaFeedPipe callbacks (same word ramp, verified by the consumer)
+static const u32 pipeNBuffers = 16;
+static const u32 pipeBufferSize = 8 << 10;
+
+#ifdef XHOST_MODEL
+// === single direction benchmark (host model only: needs XHost_AxiDmaStreamRead() / -Write() as sink / source) ===
+// playout (Tx only) and capture (Rx only) through dmaFeedBasic with the other channel unused (dmaFeedBaseConfig::useTx /
+// useRx), vs. both channels (loopback). Capture: the source ends a packet every singleDirPacketSize bytes
+static const u32 singleDirNBytes = 4 << 20;
+static const u32 singleDirPacketSize = 64 << 10;
+#endif
+
+// === multi-engine benchmark ===
+// the same transfer on 1..N engines at the same time; aggregate throughput over all engines
+static const u32 multiEngineNBytes = 4 << 20; // per engine
+
+// DMA engines in the block design: device ID, MM2S and S2MM interrupt IDs
+static const u32 engineIds[][3] = {
+#ifdef XPAR_INTC_0_DEVICE_ID
+	{XPAR_AXIDMA_0_DEVICE_ID, XPAR_INTC_0_AXIDMA_0_MM2S_INTROUT_VEC_ID, XPAR_INTC_0_AXIDMA_0_S2MM_INTROUT_VEC_ID},
+#else
+	{XPAR_AXIDMA_0_DEVICE_ID, XPAR_FABRIC_AXIDMA_0_MM2S_INTROUT_VEC_ID, XPAR_FABRIC_AXIDMA_0_S2MM_INTROUT_VEC_ID},
+#	ifdef XPAR_AXIDMA_1_DEVICE_ID
+	{XPAR_AXIDMA_1_DEVICE_ID, XPAR_FABRIC_AXIDMA_1_MM2S_INTROUT_VEC_ID, XPAR_FABRIC_AXIDMA_1_S2MM_INTROUT_VEC_ID},
+#	endif
+#	ifdef XPAR_AXIDMA_2_DEVICE_ID
+	{XPAR_AXIDMA_2_DEVICE_ID, XPAR_FABRIC_AXIDMA_2_MM2S_INTROUT_VEC_ID, XPAR_FABRIC_AXIDMA_2_S2MM_INTROUT_VEC_ID},
+#	endif
+#	ifdef XPAR_AXIDMA_3_DEVICE_ID
+	{XPAR_AXIDMA_3_DEVICE_ID, XPAR_FABRIC_AXIDMA_3_MM2S_INTROUT_VEC_ID, XPAR_FABRIC_AXIDMA_3_S2MM_INTROUT_VEC_ID},
+#	endif
+#endif
+};
+
+#define N_ELEM(a) (sizeof(a) / sizeof((a)[0]))
+
+typedef struct {
+	u32 maxPacketSize;
+	u32 nBytes;
+	u32 nBytesAllocBd;
+	u32 coalesceN;
+	u32 coalesceDelay;
+	bool coalesceAdaptive;
+	dmaFeedBaseConfig::completion_e completionMode;
+} benchCase_t;
+
+typedef struct {
+	// run duration in XTime_GetTime() units, sorted ascending after all runs
+	u64 t[nRuns];
+	u64 nTxInterrupts;
+	u64 nRxInterrupts;
+	u64 isrTime;
+	u64 nBds; // Tx and Rx BDs collected in interrupt callbacks (DEFERRED: bottom half)
+	u64 nCoalesceUp;
+	u64 nCoalesceDown;
+	u64 collectTime; // in collectTx() / collectRx()
+	u64 queueTime; // in queue()
+	u64 nDry; // Tx or Rx ring ran dry with more data to queue
+	u32 nHwBdsMin; // Rx low-water mark over all runs
+	u32 nHwBdsMax; // Tx high-water mark over all runs
+	u64 startupTime; // dmaFeedBasic constructor
+	unsigned int nVerifyErrors;
+	unsigned int nDmaErrors;
+} benchResult_t;
+
+static bool skipCase(const benchCase_t& c){
+	// coalescing without delay timer never interrupts for the last (fewer than coalesceN) packets => would hang
+	if ((c.coalesceN > 1) && !c.coalesceDelay)
+		return true;
+	if (c.nBytes / c.maxPacketSize > maxBdsPerRun)
+		return true;
+	// polling never enables interrupts => coalescing settings are irrelevant, run once
+	if ((c.completionMode == dmaFeedBaseConfig::DMAFEED_COMPLETION_POLL) && ((c.coalesceN != sweepCoalesceN[0]) || (c.coalesceDelay != sweepCoalesceDelay[0]) || c.coalesceAdaptive))
+		return true;
+	// adaptive coalescing needs the delay timer
+	if (c.coalesceAdaptive && !c.coalesceDelay)
+		return true;
+	return false;
+}
+
+// one transfer, returns duration or 0 on DMA error
+static u64 runOnce(dmaFeedBasic& d, u32* txBuf, u32* rxBuf, u32 nBytes){
+	u64 t1, t2;
+	XTime_GetTime(&t1);
+	d.runStart((char*)txBuf, nBytes, (char*)rxBuf, nBytes);
+	dmaFeedBase::run_poll_e status;
+	while (true){
+		status = d.run_poll();
+		if (status != dmaFeedBase::DMAFEED_BUSY)
+			break;
+	} // while busy
+	XTime_GetTime(&t2);
+	return (status == dmaFeedBase::DMAFEED_IDLE) ? t2 - t1 : 0;
+}
+
+static void runCase(const benchCase_t& c, const dmaFeedBasicConfig& cBase, u32* txBuf, u32* rxBuf, benchResult_t& r){
+	memset(&r, 0, sizeof(r));
+	r.nHwBdsMin = 0xFFFFFFFF;
+
+	// set up DMA wrapper for testing
+	dmaFeedBasicConfig cfg(cBase);
+	cfg.maxPacketSize = c.maxPacketSize;
+	if (c.nBytesAllocBd){
+		cfg.nBytesAllocTxBd = c.nBytesAllocBd;
+		cfg.nBytesAllocRxBd = c.nBytesAllocBd;
+	} else
+		cfg.sizeRings(c.nBytes, c.maxPacketSize);
+	cfg.coalesceNTxInterrupts = c.coalesceN;
+	cfg.coalesceNRxInterrupts = c.coalesceN;
+	cfg.coalesceDelayTx = c.coalesceDelay;
+	cfg.coalesceDelayRx = c.coalesceDelay;
+	cfg.coalesceAdaptive = c.coalesceAdaptive;
+	cfg.completionMode = c.completionMode;
+	// startup: BD memory (dmaBdArena) and ring creation
+	XTime t0;
+	XTime_GetTime(&t0);
+	dmaFeedBasic d(cfg);
+	XTime t1;
+	XTime_GetTime(&t1);
+	r.startupTime = t1 - t0;
+
+	for (unsigned int ix = 0; ix < nWarmupRuns; ++ix)
+		runOnce(d, txBuf, rxBuf, c.nBytes);
+
+	for (unsigned int ixRun = 0; ixRun < nRuns; ++ixRun){
+		// overwrite Rx buffer to detect data error
+		memset(rxBuf, /*value*/0, c.nBytes);
+		d.resetStats();
+
+		r.t[ixRun] = runOnce(d, txBuf, rxBuf, c.nBytes);
+		if (!r.t[ixRun]){
+			++r.nDmaErrors;
+			continue;
+		}
+		dmaFeedBase::stats_t s = d.getStats();
+		r.nTxInterrupts += s.tx.nInterrupts;
+		r.nRxInterrupts += s.rx.nInterrupts;
+		r.isrTime += s.tx.isrTime + s.rx.isrTime;
+		r.nBds += s.tx.nBds + s.rx.nBds;
+		r.nCoalesceUp += s.tx.nCoalesceUp + s.rx.nCoalesceUp;
+		r.nCoalesceDown += s.tx.nCoalesceDown + s.rx.nCoalesceDown;
+		r.collectTime += s.collectTime;
+		r.queueTime += s.queueTime;
+		r.nDry += s.tx.nDry + s.rx.nDry;
+		r.nHwBdsMin = std::min(r.nHwBdsMin, s.rx.nHwBdsMin);
+		r.nHwBdsMax = std::max(r.nHwBdsMax, s.tx.nHwBdsMax);
+
+		if (memcmp(txBuf, rxBuf, c.nBytes))
+			++r.nVerifyErrors;
+	}
+	std::sort(r.t, r.t + nRuns);
+}
+
+static void printCsvHeader(){
+	printf("maxPacketSize,nBytes,nBytesAllocBd,coalesceN,coalesceDelay,adaptive,completion,runs,dmaErrors,verifyErrors,min_us,median_us,max_us,median_MBps,txIrqPerRun,rxIrqPerRun,isrUsPerRun,bdsPerIrq,coalesceUpPerRun,coalesceDownPerRun,collectUsPerRun,queueUsPerRun,dryPerRun,rxHwBdsMin,txHwBdsMax,startup_us\n");
+}
+
+// min / median / max in microseconds over sorted run times. DMA error runs report t=0 and sort to the front => successful runs only.
+// No percentile tail: with nRuns runs, p99 would be the max
+static void timeStats(const u64* tSorted, unsigned int nDmaErrors, double& tMin, double& tMedian, double& tMax){
+	unsigned int nOk = nRuns - nDmaErrors;
+	const u64* t = tSorted + nDmaErrors;
+	double us = 1e6 / COUNTS_PER_SECOND;
+	tMin = nOk ? t[0] * us : 0;
+	tMedian = nOk ? t[nOk / 2] * us : 0;
+	tMax = nOk ? t[nOk - 1] * us : 0;
+}
+
+static void printCsvLine(const benchCase_t& c, const benchResult_t& r){
+	unsigned int nOk = nRuns - r.nDmaErrors;
+	double us = 1e6 / COUNTS_PER_SECOND;
+	double tMin, tMedian, tMax;
+	timeStats(r.t, r.nDmaErrors, tMin, tMedian, tMax);
+	double mbps = tMedian ? c.nBytes / tMedian : 0; // bytes per microsecond = megabytes per second
+	double perRun = nOk ? 1.0 / nOk : 0;
+	u64 nIrq = r.nTxInterrupts + r.nRxInterrupts;
+	double bdsPerIrq = nIrq ? (double)r.nBds / nIrq : 0;
+	// low-water mark not reached (no refill after collecting, e.g. all BDs fit the ring, or no stats): -1
+	long hwBdsMin = (r.nHwBdsMin == 0xFFFFFFFF) ? -1 : (long)r.nHwBdsMin;
+	printf("%u,%u,%u,%u,%u,%u,%s,%u,%u,%u,%.3f,%.3f,%.3f,%.3f,%.1f,%.1f,%.3f,%.1f,%.1f,%.1f,%.3f,%.3f,%.1f,%ld,%u,%.3f\n",
+			(unsigned)c.maxPacketSize, (unsigned)c.nBytes, (unsigned)c.nBytesAllocBd, (unsigned)c.coalesceN, (unsigned)c.coalesceDelay, (unsigned)c.coalesceAdaptive, completionModeName[c.completionMode],
+			nRuns, r.nDmaErrors, r.nVerifyErrors,
+			tMin, tMedian, tMax, mbps,
+			r.nTxInterrupts * perRun, r.nRxInterrupts * perRun, r.isrTime * us * perRun,
+			bdsPerIrq, r.nCoalesceUp * perRun, r.nCoalesceDown * perRun,
+			r.collectTime * us * perRun, r.queueTime * us * perRun, r.nDry * perRun, hwBdsMin, (unsigned)r.nHwBdsMax, r.startupTime * us);
+}
+
+typedef struct {
+	std::atomic<unsigned int> nOk; // written by job callbacks (interrupt context)
+	std::atomic<unsigned int> nFailed;
+} jobCounter_t;
+
+static void jobDone(void* context, bool ok){
+	jobCounter_t* c = (jobCounter_t*)context;
+	if (ok)
+		++c->nOk;
+	else
+		++c->nFailed;
+}
+
+// nJobsPerRun jobs of jobSize bytes at consecutive offsets, sequentially through dmaFeedBasic. Returns duration or 0 on DMA error
+static u64 runJobsBasic(dmaFeedBasic& d, u32* txBuf, u32* rxBuf, u32 jobSize){
+	u64 t1, t2;
+	XTime_GetTime(&t1);
+	for (unsigned int ixJob = 0; ixJob < nJobsPerRun; ++ixJob){
+		u32 offset = ixJob * jobSize;
+		d.runStart((char*)txBuf + offset, jobSize, (char*)rxBuf + offset, jobSize);
+		dmaFeedBase::run_poll_e status;
+		while ((status = d.run_poll()) == dmaFeedBase::DMAFEED_BUSY){}
+		if (status != dmaFeedBase::DMAFEED_IDLE)
+			return 0;
+	}
+	XTime_GetTime(&t2);
+	return t2 - t1;
+}
+
+// same jobs through the dmaFeedJobs submission queue (already started). Returns duration or 0 on DMA error
+static u64 runJobsQueued(dmaFeedJobs& d, u32* txBuf, u32* rxBuf, u32 jobSize){
+	jobCounter_t counter = {0, 0};
+	u64 t1, t2;
+	XTime_GetTime(&t1);
+	for (unsigned int ixJob = 0; ixJob < nJobsPerRun; ++ixJob){
+		u32 offset = ixJob * jobSize;
+		dmaFeedJobs::job_t job = {(char*)txBuf + offset, jobSize, (char*)rxBuf + offset, jobSize, jobDone, &counter};
+		while (!d.submit(job))
+			if (d.run_poll() == dmaFeedBase::DMAFEED_IDLE_ERROR)
+				return 0;
+	}
+	while (counter.nOk < nJobsPerRun)
+		if (d.run_poll() == dmaFeedBase::DMAFEED_IDLE_ERROR)
+			return 0;
+	XTime_GetTime(&t2);
+	return t2 - t1;
+}
+
+// warm-up and timed runs of run() (one batch of nJobsPerRun jobs, returns duration or 0 on DMA error), sorts t
+template<typename run_t> static void runJobsRepeated(run_t run, u32* txBuf, u32* rxBuf, u32 nBytes, u64* t, unsigned int& nDmaErrors, unsigned int& nVerifyErrors){
+	for (unsigned int ixRun = 0; ixRun < nWarmupRuns + nRuns; ++ixRun){
+		// overwrite Rx buffer to detect data error
+		memset(rxBuf, /*value*/0, nBytes);
+		u64 dt = run();
+		if (ixRun < nWarmupRuns)
+			continue;
+		t[ixRun - nWarmupRuns] = dt;
+		if (!dt)
+			++nDmaErrors;
+		else if (memcmp(txBuf, rxBuf, nBytes))
+			++nVerifyErrors;
+	}
+	std::sort(t, t + nRuns);
+}
+
+static void runJobsCase(u32 jobSize, bool queued, const dmaFeedBaseConfig& cBase, u32* txBuf, u32* rxBuf){
+	u64 t[nRuns];
+	unsigned int nDmaErrors = 0;
+	unsigned int nVerifyErrors = 0;
+	u32 nBytes = nJobsPerRun * jobSize;
+	if (queued){
+		dmaFeedJobs d(dmaFeedJobsConfig(cBase.dmaDevId, cBase.txIntrId, cBase.rxIntrId));
+		d.runStart();
+		runJobsRepeated([&]{
+			u64 dt = runJobsQueued(d, txBuf, rxBuf, jobSize);
+			if (!dt)
+				d.runStart(); // restart after error, fails outstanding jobs
+			return dt;
+		}, txBuf, rxBuf, nBytes, t, nDmaErrors, nVerifyErrors);
+	} else {
+		dmaFeedBasic d(dmaFeedBasicConfig(cBase.dmaDevId, cBase.txIntrId, cBase.rxIntrId));
+		runJobsRepeated([&]{return runJobsBasic(d, txBuf, rxBuf, jobSize);}, txBuf, rxBuf, nBytes, t, nDmaErrors, nVerifyErrors);
+	}
+
+	double tMin, tMedian, tMax;
+	timeStats(t, nDmaErrors, tMin, tMedian, tMax);
+	printf("%u,%u,%s,%u,%u,%u,%.3f,%.3f,%.3f,%.3f\n",
+			(unsigned)jobSize, nJobsPerRun, queued ? "queued" : "sequential",
+			nRuns, nDmaErrors, nVerifyErrors,
+			tMin, tMedian, tMax, tMedian ? nBytes / tMedian : 0);
+}
+
+#ifdef XHOST_MODEL
+// same jobs as requests to a dmaServiceCore whose run() loop is in another thread. Returns duration or 0 if a job failed
+static u64 runJobsServiceCore(dmaServiceCore& sc, u32* txBuf, u32* rxBuf, u32 jobSize){
+	unsigned int nSubmitted = 0;
+	unsigned int nDone = 0;
+	bool ok = true;
+	u64 t1, t2;
+	XTime_GetTime(&t1);
+	while (nDone < nJobsPerRun){
+		bool progress = false;
+		if (nSubmitted < nJobsPerRun){
+			u32 offset = nSubmitted * jobSize;
+			dmaServiceCore::request_t r = {(char*)txBuf + offset, jobSize, (char*)rxBuf + offset, jobSize, NULL};
+			if (sc.submit(r)){
+				++nSubmitted;
+				progress = true;
+			}
+		}
+		dmaServiceCore::completion_t c;
+		while (sc.getCompletion(c)){
+			++nDone;
+			ok = ok && c.ok;
+			progress = true;
+		}
+		if (!progress)
+			std::this_thread::yield(); // share the host CPU with the service thread
+	}
+	XTime_GetTime(&t2);
+	return ok ? t2 - t1 : 0;
+}
+
+static void serviceCoreIdle(void* context){
+	(void)context;
+	std::this_thread::yield();
+}
+
+// mode 0: dmaFeedJobs in this thread (IRQ completion), 1: dmaServiceCore (IRQ), 2: dmaServiceCore (DEFERRED)
+static void runServiceCoreCase(u32 jobSize, unsigned int mode, const dmaFeedBaseConfig& cBase, u32* txBuf, u32* rxBuf){
+	static const char* const modeName[] = {"local", "serviceCore", "serviceCoreDeferred"};
+	u64 t[nRuns];
+	unsigned int nDmaErrors = 0;
+	unsigned int nVerifyErrors = 0;
+	u32 nBytes = nJobsPerRun * jobSize;
+	dmaFeedJobsConfig cfg(cBase.dmaDevId, cBase.txIntrId, cBase.rxIntrId);
+	if (mode == 2)
+		cfg.completionMode = dmaFeedBaseConfig::DMAFEED_COMPLETION_DEFERRED;
+	dmaFeedJobs d(cfg);
+	if (mode == 0){
+		d.runStart();
+		runJobsRepeated([&]{
+			u64 dt = runJobsQueued(d, txBuf, rxBuf, jobSize);
+			if (!dt)
+				d.runStart(); // restart after error, fails outstanding jobs
+			return dt;
+		}, txBuf, rxBuf, nBytes, t, nDmaErrors, nVerifyErrors);
+	} else {
+		dmaServiceCore sc(d, serviceCoreNRequests);
+		std::thread service([&]{sc.run(serviceCoreIdle, NULL);});
+		runJobsRepeated([&]{return runJobsServiceCore(sc, txBuf, rxBuf, jobSize);}, txBuf, rxBuf, nBytes, t, nDmaErrors, nVerifyErrors);
+		sc.stop();
+		service.join();
+	}
+
+	double tMin, tMedian, tMax;
+	timeStats(t, nDmaErrors, tMin, tMedian, tMax);
+	printf("%u,%u,%s,%u,%u,%u,%.3f,%.3f,%.3f,%.3f\n",
+			(unsigned)jobSize, nJobsPerRun, modeName[mode],
+			nRuns, nDmaErrors, nVerifyErrors,
+			tMin, tMedian, tMax, tMedian ? nBytes / tMedian : 0);
+}
+#endif
+
+// nJobsPerRun times the same transfer, BDs programmed by runStart() or replayed. Returns duration or 0 on DMA error
+static u64 runRepeated(dmaFeedBasic& d, bool replay, u32* txBuf, u32* rxBuf, u32 nBytes){
+	u64 t1, t2;
+	XTime_GetTime(&t1);
+	for (unsigned int ixJob = 0; ixJob < nJobsPerRun; ++ixJob){
+		if (replay)
+			d.runReplay();
+		else
+			d.runStart((char*)txBuf, nBytes, (char*)rxBuf, nBytes);
+		dmaFeedBase::run_poll_e status;
+		while ((status = d.run_poll()) == dmaFeedBase::DMAFEED_BUSY){}
+		if (status != dmaFeedBase::DMAFEED_IDLE)
+			return 0;
+	}
+	XTime_GetTime(&t2);
+	return t2 - t1;
+}
+
+static void runReplayCase(u32 nBytes, bool replay, const dmaFeedBasicConfig& cBase, u32* txBuf, u32* rxBuf){
+	dmaFeedBasicConfig cfg(cBase);
+	cfg.maxPacketSize = replayMaxPacketSize;
+	cfg.replay = replay;
+	dmaFeedBasic d(cfg);
+	if (replay){
+		// record
+		d.runStart((char*)txBuf, nBytes, (char*)rxBuf, nBytes);
+		while (d.run_poll() == dmaFeedBase::DMAFEED_BUSY){}
+	}
+	u64 t[nRuns];
+	unsigned int nDmaErrors = 0;
+	unsigned int nVerifyErrors = 0;
+	runJobsRepeated([&]{return runRepeated(d, replay, txBuf, rxBuf, nBytes);}, txBuf, rxBuf, nBytes, t, nDmaErrors, nVerifyErrors);
+
+	double tMin, tMedian, tMax;
+	timeStats(t, nDmaErrors, tMin, tMedian, tMax);
+	printf("%u,%u,%u,%s,%u,%u,%u,%.3f,%.3f,%.3f\n",
+			(unsigned)nBytes, (unsigned)replayMaxPacketSize, nJobsPerRun, replay ? "replay" : "program",
+			nRuns, nDmaErrors, nVerifyErrors,
+			tMin, tMedian, tMedian / nJobsPerRun);
+}
+
+// nJobsPerRun transactions completing on RXEOF, mode 0: burst, 1: single, 2: consecutive (see eofPacketSize). Each packet is
+// checked against its Tx data (nVerifyErrors). Returns duration or 0 on DMA error
+static u64 runEofOnce(dmaFeedBasic& d, unsigned int mode, u32* txBuf, u32* rxBuf, unsigned int& nVerifyErrors){
+	u32 nTxBytes = (mode == 0) ? eofNBurst * eofPacketSize : eofPacketSize;
+	u32 rxOffset = 0;
+	u64 t1, t2;
+	XTime_GetTime(&t1);
+	for (unsigned int ixJob = 0; ixJob < nJobsPerRun; ++ixJob){
+		char* tx = (char*)txBuf + ixJob * eofPacketSize; // distinct data per transaction => detects a stale Rx buffer
+		char* rx = (char*)rxBuf + rxOffset;
+		d.runStart(tx, nTxBytes, rx, eofCapacity);
+		dmaFeedBase::run_poll_e status;
+		while ((status = d.run_poll()) == dmaFeedBase::DMAFEED_BUSY){}
+		if (status != dmaFeedBase::DMAFEED_IDLE)
+			return 0;
+		if ((d.getRxBytesReceived() != eofPacketSize) || memcmp(tx, rx, eofPacketSize))
+			++nVerifyErrors;
+		if (mode == 2)
+			rxOffset += d.getRxBytesConsumed();
+	}
+	XTime_GetTime(&t2);
+	return t2 - t1;
+}
+
+static void runEofCase(unsigned int mode, const dmaFeedBasicConfig& cBase, u32* txBuf, u32* rxBuf){
+	static const char* const modeName[] = {"burst", "single", "consecutive"};
+	dmaFeedBasicConfig cfg(cBase);
+	cfg.maxPacketSize = eofMaxPacketSize;
+	cfg.nBytesAllocTxBd = eofPacketSize / eofMaxPacketSize * XAXIDMA_BD_MINIMUM_ALIGNMENT;
+	cfg.rxCompleteOnEof = true;
+	dmaFeedBasic d(cfg);
+
+	u64 t[nRuns];
+	unsigned int nDmaErrors = 0;
+	unsigned int nVerifyErrors = 0;
+	for (unsigned int ixRun = 0; ixRun < nWarmupRuns + nRuns; ++ixRun){
+		unsigned int nErr = 0;
+		u64 dt = runEofOnce(d, mode, txBuf, rxBuf, nErr);
+		if (ixRun < nWarmupRuns)
+			continue;
+		t[ixRun - nWarmupRuns] = dt;
+		if (!dt)
+			++nDmaErrors;
+		else if (nErr)
+			++nVerifyErrors;
+	}
+	std::sort(t, t + nRuns);
+
+	double tMin, tMedian, tMax;
+	timeStats(t, nDmaErrors, tMin, tMedian, tMax);
+	printf("%u,%u,%u,%s,%u,%u,%u,%.3f,%.3f\n",
+			(unsigned)eofPacketSize, (unsigned)eofCapacity, nJobsPerRun, modeName[mode],
+			nRuns, nDmaErrors, nVerifyErrors,
+			tMedian, tMedian / nJobsPerRun);
+}
+
+// IRQ completion with coalescing, BD fill through driver calls or templates. Time per BD from stats (-DDMAFEED_STATS=1): interrupt
+// callback over BDs collected there, queue() over BDs queued
+static void runBdFillCase(u32 maxPacketSize, bool fastBdFill, const dmaFeedBasicConfig& cBase, u32* txBuf, u32* rxBuf){
+	dmaFeedBasicConfig cfg(cBase);
+	cfg.fastBdFill = fastBdFill;
+	benchCase_t c = {maxPacketSize, bdFillNBytes, /*nBytesAllocBd*/0x10000, /*coalesceN*/8, /*coalesceDelay*/16, /*adaptive*/false, dmaFeedBaseConfig::DMAFEED_COMPLETION_IRQ};
+	benchResult_t r;
+	runCase(c, cfg, txBuf, rxBuf, r);
+
+	unsigned int nOk = nRuns - r.nDmaErrors;
+	double ns = 1e9 / COUNTS_PER_SECOND;
+	double tMin, tMedian, tMax;
+	timeStats(r.t, r.nDmaErrors, tMin, tMedian, tMax);
+	u64 nBdsQueued = (u64)nOk * 2 * (bdFillNBytes / maxPacketSize); // Tx and Rx
+	printf("%u,%u,%s,%u,%u,%u,%.3f,%.3f,%.1f,%.1f\n",
+			(unsigned)maxPacketSize, (unsigned)bdFillNBytes, fastBdFill ? "template" : "driver",
+			nRuns, r.nDmaErrors, r.nVerifyErrors,
+			tMedian, tMedian ? bdFillNBytes / tMedian : 0,
+			r.nBds ? r.isrTime * ns / r.nBds : 0, nBdsQueued ? r.queueTime * ns / nBdsQueued : 0);
+}
+
+// IRQ completion without coalescing, virtual or specialized interrupt callbacks. Time per BD from stats (-DDMAFEED_STATS=1):
+// interrupt callback and collect over BDs collected there
+static void runDispatchCase(u32 maxPacketSize, bool inlineIsr, const dmaFeedBasicConfig& cBase, u32* txBuf, u32* rxBuf){
+	dmaFeedBasicConfig cfg(cBase);
+	cfg.inlineIsr = inlineIsr;
+	benchCase_t c = {maxPacketSize, dispatchNBytes, /*nBytesAllocBd*/0x10000, /*coalesceN*/1, /*coalesceDelay*/0, /*adaptive*/false, dmaFeedBaseConfig::DMAFEED_COMPLETION_IRQ};
+	benchResult_t r;
+	runCase(c, cfg, txBuf, rxBuf, r);
+
+	double ns = 1e9 / COUNTS_PER_SECOND;
+	double tMin, tMedian, tMax;
+	timeStats(r.t, r.nDmaErrors, tMin, tMedian, tMax);
+	unsigned int nOk = nRuns - r.nDmaErrors;
+	u64 nInterrupts = r.nTxInterrupts + r.nRxInterrupts;
+	printf("%u,%u,%s,%u,%u,%u,%.3f,%.3f,%.1f,%.1f,%.1f\n",
+			(unsigned)maxPacketSize, (unsigned)dispatchNBytes, inlineIsr ? "static" : "virtual",
+			nRuns, r.nDmaErrors, r.nVerifyErrors,
+			tMedian, tMedian ? dispatchNBytes / tMedian : 0,
+			nOk ? (double)nInterrupts / nOk : 0, r.nBds ? r.isrTime * ns / r.nBds : 0, r.nBds ? r.collectTime * ns / r.nBds : 0);
+}
+
+#ifdef XHOST_MODEL
+// one capture: the source writes cyclicNBytes of txBuf as cyclicBufferSize packets, at most cyclicNBuffers - 2 ahead of the reader
+// (the cyclic ring has no backpressure). The reader copies into rxBuf: get(data, nBytes) returns the next filled buffer, if
+// any, release() hands it back (false: overrun). Returns duration, or 0 on DMA error or overrun
+template<typename get_t, typename release_t> static u64 runCaptureOnce(dmaFeedBase& d, u32 dmaDevId, get_t get, release_t release, u32* txBuf, u32* rxBuf){
+	const char* src = (const char*)txBuf;
+	char* dst = (char*)rxBuf;
+	u32 nWritten = 0;
+	u32 nRead = 0;
+	u64 t1, t2;
+	XTime_GetTime(&t1);
+	while (nRead < cyclicNBytes){
+		if ((nWritten < cyclicNBytes) && (nWritten - nRead < (cyclicNBuffers - 2) * cyclicBufferSize)){
+			// rest of the current packet (the FIFO may accept part of it), TLAST once complete
+			u32 n = cyclicBufferSize - nWritten % cyclicBufferSize;
+			nWritten += XHost_AxiDmaStreamWrite(dmaDevId, src + nWritten, n, /*Tlast*/1);
+		}
+		char* data;
+		u32 n;
+		if (get(data, n)){
+			memcpy(dst + nRead, data, n);
+			nRead += n;
+			if (!release())
+				return 0;
+		} else if (d.run_poll() != dmaFeedBase::DMAFEED_BUSY)
+			return 0;
+	}
+	XTime_GetTime(&t2);
+	return t2 - t1;
+}
+
+// rxIrqPerRun / isrUsPerRun from stats (-DDMAFEED_STATS=1), over warm-up and timed runs
+static void runCaptureCase(unsigned int mode, const dmaFeedBaseConfig& cBase, u32* txBuf, u32* rxBuf){
+	static const char* const modeName[] = {"stream", "cyclic", "cyclicPoll"};
+	u64 t[nRuns];
+	unsigned int nDmaErrors = 0;
+	unsigned int nVerifyErrors = 0;
+	dmaFeedBase::stats_t st;
+	if (mode == 0){
+		dmaFeedStreamConfig cfg(cBase.dmaDevId, cBase.txIntrId, cBase.rxIntrId);
+		cfg.nBuffers = cyclicNBuffers;
+		cfg.bufferSize = cyclicBufferSize;
+		dmaFeedStream d(cfg);
+		d.runStart();
+		unsigned int bufIx = 0;
+		runJobsRepeated([&]{
+			u64 dt = runCaptureOnce(d, cBase.dmaDevId,
+					[&](char*& data, u32& nBytes){bool eop; return d.getFilled(bufIx, data, nBytes, eop);},
+					[&]{d.release(bufIx); return true;}, txBuf, rxBuf);
+			if (!dt)
+				d.runStart();
+			return dt;
+		}, txBuf, rxBuf, cyclicNBytes, t, nDmaErrors, nVerifyErrors);
+		st = d.getStats();
+	} else {
+		dmaFeedCyclicConfig cfg(cBase.dmaDevId, cBase.txIntrId, cBase.rxIntrId);
+		cfg.nBuffers = cyclicNBuffers;
+		cfg.bufferSize = cyclicBufferSize;
+		cfg.completionMode = (mode == 1) ? dmaFeedBaseConfig::DMAFEED_COMPLETION_IRQ : dmaFeedBaseConfig::DMAFEED_COMPLETION_POLL;
+		dmaFeedCyclic d(cfg);
+		d.runStart();
+		runJobsRepeated([&]{
+			u64 dt = runCaptureOnce(d, cBase.dmaDevId,
+					[&](char*& data, u32& nBytes){unsigned int bufIx; bool eop; return d.getFilled(bufIx, data, nBytes, eop);},
+					[&]{return d.release();}, txBuf, rxBuf);
+			if (!dt)
+				d.runStart(); // after overrun or DMA error
+			return dt;
+		}, txBuf, rxBuf, cyclicNBytes, t, nDmaErrors, nVerifyErrors);
+		st = d.getStats();
+	}
+
+	double us = 1e6 / COUNTS_PER_SECOND;
+	double perRun = 1.0 / (nWarmupRuns + nRuns);
+	double tMin, tMedian, tMax;
+	timeStats(t, nDmaErrors, tMin, tMedian, tMax);
+	printf("%u,%u,%u,%s,%u,%u,%u,%.3f,%.3f,%.1f,%.3f\n",
+			(unsigned)cyclicNBuffers, (unsigned)cyclicBufferSize, (unsigned)cyclicNBytes, modeName[mode],
+			nRuns, nDmaErrors, nVerifyErrors,
+			tMedian, tMedian ? cyclicNBytes / tMedian : 0,
+			st.rx.nInterrupts * perRun, st.rx.isrTime * us * perRun);
+}
+#endif
+
+#ifdef XHOST_MODEL
+// one transfer with a Tx error injected at BD errorAtBd, recovered by resume (within run_poll()) or by a second runStart().
+// Adds resumes and Tx bytes queued twice to nResumes / nResent. Returns duration or 0 on unrecovered DMA error
+static u64 runRecoveryOnce(dmaFeedBasic& d, u32 dmaDevId, u32 errorAtBd, u32* txBuf, u32* rxBuf, u64& nResumes, u64& nResent){
+	XHost_AxiDmaInjectError(dmaDevId, /*isRx*/false, errorAtBd);
+	u64 t1, t2;
+	XTime_GetTime(&t1);
+	d.runStart((char*)txBuf, recoveryNBytes, (char*)rxBuf, recoveryNBytes);
+	dmaFeedBase& base = d; // resume must not depend on the static type run_poll() is called through
+	dmaFeedBase::run_poll_e status;
+	while ((status = base.run_poll()) == dmaFeedBase::DMAFEED_BUSY){}
+	nResumes += d.getNResumes();
+	nResent += d.getTxBytesRetransmitted();
+	if (status == dmaFeedBase::DMAFEED_IDLE_ERROR){
+		// restart: everything queued so far is queued again (same measure as getTxBytesRetransmitted())
+		nResent += d.getTxBytesQueued();
+		d.runStart((char*)txBuf, recoveryNBytes, (char*)rxBuf, recoveryNBytes);
+		while ((status = d.run_poll()) == dmaFeedBase::DMAFEED_BUSY){}
+	}
+	XTime_GetTime(&t2);
+	return (status == dmaFeedBase::DMAFEED_IDLE) ? t2 - t1 : 0;
+}
+
+// resumesPerRun / resentKBPerRun over warm-up and timed runs
+static void runRecoveryCase(u32 errorAtBd, bool resume, const dmaFeedBasicConfig& cBase, u32* txBuf, u32* rxBuf){
+	dmaFeedBasicConfig cfg(cBase);
+	cfg.maxPacketSize = recoveryMaxPacketSize;
+	cfg.resumeMaxRetries = resume ? 1 : 0;
+	dmaFeedBasic d(cfg);
+	u64 t[nRuns];
+	unsigned int nDmaErrors = 0;
+	unsigned int nVerifyErrors = 0;
+	u64 nResumes = 0;
+	u64 nResent = 0;
+	runJobsRepeated([&]{return runRecoveryOnce(d, cfg.dmaDevId, errorAtBd, txBuf, rxBuf, nResumes, nResent);}, txBuf, rxBuf, recoveryNBytes, t, nDmaErrors, nVerifyErrors);
+
+	double perRun = 1.0 / (nWarmupRuns + nRuns);
+	double tMin, tMedian, tMax;
+	timeStats(t, nDmaErrors, tMin, tMedian, tMax);
+	printf("%u,%u,%s,%u,%u,%u,%u,%.3f,%.3f,%.2f,%.1f\n",
+			(unsigned)recoveryNBytes, (unsigned)recoveryMaxPacketSize, resume ? "resume" : "restart", (unsigned)errorAtBd,
+			nRuns, nDmaErrors, nVerifyErrors,
+			tMedian, tMedian ? recoveryNBytes / tMedian : 0,
+			nResumes * perRun, nResent * perRun / 1024);
+}
+#endif
+
+// dmaFeedPipe producer / consumer: the ramp of the benchmark's Tx buffer (txBuf[ix] = ix), verified on the Rx side
+typedef struct {
+	u32 next; // next word of the ramp
+	unsigned int nErrors; // consumer: words that differ
+} ramp_t;
+
+static void rampProduce(void* context, char* data, u32 nBytes){
+	ramp_t* r = (ramp_t*)context;
+	u32* p = (u32*)data;
+	for (u32 ix = 0; ix < nBytes / sizeof(u32); ++ix)
+		p[ix] = r->next++;
+}
+
+static void rampConsume(void* context, const char* data, u32 nBytes){
+	ramp_t* r = (ramp_t*)context;
+	const u32* p = (const u32*)data;
+	for (u32 ix = 0; ix < nBytes / sizeof(u32); ++ix)
+		r->nErrors += (p[ix] != r->next++);
+}
+
+// one transfer through the producer / consumer callbacks. Returns duration or 0 on DMA error
+static u64 runPipeOnce(dmaFeedPipe& d, ramp_t& tx, ramp_t& rx, u32 nBytes){
+	tx = {0, 0};
+	rx = {0, 0};
+	u64 t1, t2;
+	XTime_GetTime(&t1);
+	d.runStart(nBytes, nBytes);
+	dmaFeedBase::run_poll_e status;
+	while ((status = d.run_poll()) == dmaFeedBase::DMAFEED_BUSY){}
+	XTime_GetTime(&t2);
+	return (status == dmaFeedBase::DMAFEED_IDLE) ? t2 - t1 : 0;
+}
+
+// bufferKB: data buffer memory of the run (dmaFeedBasic: Tx and Rx buffer, dmaFeedPipe: its pool)
+static void runPipeCase(u32 nBytes, bool pipe, const dmaFeedBaseConfig& cBase, u32* txBuf, u32* rxBuf){
+	u64 t[nRuns];
+	unsigned int nDmaErrors = 0;
+	unsigned int nVerifyErrors = 0;
+	u32 nBufferBytes;
+	if (pipe){
+		dmaFeedPipeConfig cfg(cBase.dmaDevId, cBase.txIntrId, cBase.rxIntrId);
+		cfg.nTxBuffers = pipeNBuffers;
+		cfg.nRxBuffers = pipeNBuffers;
+		cfg.bufferSize = pipeBufferSize;
+		dmaFeedPipe d(cfg);
+		ramp_t tx, rx;
+		d.setProducer(rampProduce, &tx);
+		d.setConsumer(rampConsume, &rx);
+		for (unsigned int ixRun = 0; ixRun < nWarmupRuns + nRuns; ++ixRun){
+			u64 dt = runPipeOnce(d, tx, rx, nBytes);
+			if (ixRun < nWarmupRuns)
+				continue;
+			t[ixRun - nWarmupRuns] = dt;
+			if (!dt)
+				++nDmaErrors;
+			else if (rx.nErrors || (rx.next != nBytes / sizeof(u32)))
+				++nVerifyErrors;
+		}
+		std::sort(t, t + nRuns);
+		nBufferBytes = 2 * pipeNBuffers * pipeBufferSize;
+	} else {
+		dmaFeedBasic d(dmaFeedBasicConfig(cBase.dmaDevId, cBase.txIntrId, cBase.rxIntrId));
+		runJobsRepeated([&]{return runOnce(d, txBuf, rxBuf, nBytes);}, txBuf, rxBuf, nBytes, t, nDmaErrors, nVerifyErrors);
+		nBufferBytes = 2 * nBytes;
+	}
+
+	double tMin, tMedian, tMax;
+	timeStats(t, nDmaErrors, tMin, tMedian, tMax);
+	printf("%u,%s,%u,%u,%u,%.3f,%.3f,%u\n",
+			(unsigned)nBytes, pipe ? "pipe" : "memory",
+			nRuns, nDmaErrors, nVerifyErrors,
+			tMedian, tMedian ? nBytes / tMedian : 0, (unsigned)(nBufferBytes >> 10));
+}
+
+#ifdef XHOST_MODEL
+// one transfer of singleDirNBytes. mode 0: loopback, 1: Tx only into the sink (read into rxBuf), 2: Rx only from the source
+// (txBuf). Returns duration or 0 on DMA error
+static u64 runSingleDirOnce(dmaFeedBasic& d, unsigned int mode, u32 dmaDevId, u32* txBuf, u32* rxBuf){
+	const char* src = (const char*)txBuf;
+	char* dst = (char*)rxBuf;
+	u32 nStreamed = 0; // through the sink / source
+	u64 t1, t2;
+	XTime_GetTime(&t1);
+	if (mode == 1)
+		d.runStart((char*)txBuf, singleDirNBytes, NULL, 0);
+	else if (mode == 2)
+		d.runStart(NULL, 0, (char*)rxBuf, singleDirNBytes);
+	else
+		d.runStart((char*)txBuf, singleDirNBytes, (char*)rxBuf, singleDirNBytes);
+	dmaFeedBase::run_poll_e status;
+	do {
+		if ((mode == 1) && (nStreamed < singleDirNBytes))
+			nStreamed += XHost_AxiDmaStreamRead(dmaDevId, dst + nStreamed, singleDirNBytes - nStreamed);
+		else if ((mode == 2) && (nStreamed < singleDirNBytes)){
+			// rest of the current packet (the FIFO may accept part of it), TLAST once complete
+			u32 n = singleDirPacketSize - nStreamed % singleDirPacketSize;
+			nStreamed += XHost_AxiDmaStreamWrite(dmaDevId, src + nStreamed, n, /*Tlast*/1);
+		}
+		status = d.run_poll();
+	} while ((status == dmaFeedBase::DMAFEED_BUSY) || ((mode == 1) && (status == dmaFeedBase::DMAFEED_IDLE) && (nStreamed < singleDirNBytes)));
+	XTime_GetTime(&t2);
+	return (status == dmaFeedBase::DMAFEED_IDLE) ? t2 - t1 : 0;
+}
+
+// startup_us: median over nRuns constructions. txIrqPerRun / rxIrqPerRun from stats (-DDMAFEED_STATS=1), over warm-up and
+// timed runs
+static void runSingleDirCase(unsigned int mode, const dmaFeedBasicConfig& cBase, u32* txBuf, u32* rxBuf){
+	static const char* const modeName[] = {"loopback", "txOnly", "rxOnly"};
+	dmaFeedBasicConfig cfg(cBase);
+	cfg.useTx = (mode != 2);
+	cfg.useRx = (mode != 1);
+
+	// startup: BD rings of the used channels
+	u64 tStartup[nRuns];
+	for (unsigned int ixRun = 0; ixRun < nRuns; ++ixRun){
+		XTime t0, t1;
+		XTime_GetTime(&t0);
+		{
+			dmaFeedBasic d(cfg);
+			XTime_GetTime(&t1);
+		}
+		tStartup[ixRun] = t1 - t0;
+	}
+	std::sort(tStartup, tStartup + nRuns);
+
+	dmaFeedBasic d(cfg);
+	u64 t[nRuns];
+	unsigned int nDmaErrors = 0;
+	unsigned int nVerifyErrors = 0;
+	runJobsRepeated([&]{return runSingleDirOnce(d, mode, cfg.dmaDevId, txBuf, rxBuf);}, txBuf, rxBuf, singleDirNBytes, t, nDmaErrors, nVerifyErrors);
+	dmaFeedBase::stats_t st = d.getStats();
+
+	double us = 1e6 / COUNTS_PER_SECOND;
+	double perRun = 1.0 / (nWarmupRuns + nRuns);
+	double tMin, tMedian, tMax;
+	timeStats(t, nDmaErrors, tMin, tMedian, tMax);
+	printf("%u,%s,%u,%u,%u,%.3f,%.3f,%.3f,%.1f,%.1f\n",
+			(unsigned)singleDirNBytes, modeName[mode],
+			nRuns, nDmaErrors, nVerifyErrors,
+			tMedian, tMedian ? singleDirNBytes / tMedian : 0, tStartup[nRuns / 2] * us,
+			st.tx.nInterrupts * perRun, st.rx.nInterrupts * perRun);
+}
+#endif
+
+// starts all engines, then polls until every one is idle. Returns duration or 0 on DMA error
+static u64 runMultiEngineOnce(dmaFeedBasic* const* d, unsigned int nEngines, u32* const* txBufs, u32* const* rxBufs){
+	u64 t1, t2;
+	XTime_GetTime(&t1);
+	for (unsigned int ix = 0; ix < nEngines; ++ix)
+		d[ix]->runStart((char*)txBufs[ix], multiEngineNBytes, (char*)rxBufs[ix], multiEngineNBytes);
+	bool error = false;
+	unsigned int nBusy;
+	do {
+		nBusy = 0;
+		for (unsigned int ix = 0; ix < nEngines; ++ix){
+			dmaFeedBase::run_poll_e status = d[ix]->run_poll();
+			if (status == dmaFeedBase::DMAFEED_BUSY)
+				++nBusy;
+			else if (status == dmaFeedBase::DMAFEED_IDLE_ERROR)
+				error = true;
+		}
+	} while (nBusy);
+	XTime_GetTime(&t2);
+	return error ? 0 : t2 - t1;
+}
+
+static void runMultiEngineCase(unsigned int nEngines, dmaBufferPool& pool){
+	dmaFeedBasic* d[N_ELEM(engineIds)];
+	u32* txBufs[N_ELEM(engineIds)];
+	u32* rxBufs[N_ELEM(engineIds)];
+	for (unsigned int ix = 0; ix < nEngines; ++ix){
+		d[ix] = new dmaFeedBasic(dmaFeedBasicConfig(engineIds[ix][0], engineIds[ix][1], engineIds[ix][2]));
+		txBufs[ix] = (u32*)pool.alloc(); assert(txBufs[ix]);
+		rxBufs[ix] = (u32*)pool.alloc(); assert(rxBufs[ix]);
+		for (u32 ixWord = 0; ixWord < multiEngineNBytes / sizeof(u32); ++ixWord)
+			txBufs[ix][ixWord] = ixWord ^ (ix << 24); // distinct per engine => detects crossed buffers
+	}
+
+	u64 t[nRuns];
+	unsigned int nDmaErrors = 0;
+	unsigned int nVerifyErrors = 0;
+	for (unsigned int ixRun = 0; ixRun < nWarmupRuns + nRuns; ++ixRun){
+		for (unsigned int ix = 0; ix < nEngines; ++ix)
+			memset(rxBufs[ix], /*value*/0, multiEngineNBytes);
+		u64 dt = runMultiEngineOnce(d, nEngines, txBufs, rxBufs);
+		if (ixRun < nWarmupRuns)
+			continue;
+		t[ixRun - nWarmupRuns] = dt;
+		if (!dt){
+			++nDmaErrors;
+			continue;
+		}
+		for (unsigned int ix = 0; ix < nEngines; ++ix)
+			if (memcmp(txBufs[ix], rxBufs[ix], multiEngineNBytes))
+				++nVerifyErrors;
+	}
+	std::sort(t, t + nRuns);
+
+	for (unsigned int ix = 0; ix < nEngines; ++ix){
+		delete d[ix];
+		pool.free((char*)txBufs[ix]);
+		pool.free((char*)rxBufs[ix]);
+	}
+
+	double tMin, tMedian, tMax;
+	timeStats(t, nDmaErrors, tMin, tMedian, tMax);
+	printf("%u,%u,%u,%u,%u,%.3f,%.3f,%.3f,%.3f\n",
+			nEngines, (unsigned)multiEngineNBytes,
+			nRuns, nDmaErrors, nVerifyErrors,
+			tMin, tMedian, tMax, tMedian ? (double)nEngines * multiEngineNBytes / tMedian : 0);
+}
+
 int main(void){
 	// identify interrupts (need DMA0 configured with interrupts, connected to PS via concat)
 #ifdef XPAR_INTC_0_DEVICE_ID
@@ -11,101 +936,128 @@ int main(void){
 	const u32 txIntrId = XPAR_FABRIC_AXIDMA_0_MM2S_INTROUT_VEC_ID;
 	const u32 rxIntrId = XPAR_FABRIC_AXIDMA_0_S2MM_INTROUT_VEC_ID;
 #endif
-	printf("=== scatter-gather DMA wrapper test===\n");
+	printf("# === scatter-gather DMA wrapper benchmark ===\n");
 
 	// top-level exception handler (all interrupts)
 	dmaFeedBase::installGlobalIrqExceptionHandler();
+#ifdef XHOST_MODEL
+	// loopback FIFO reset wired to s2mm_prmry_reset_out_n, as resume after error needs (see README): a DMA reset (error,
+	// abort()) drops the data in flight
+	for (const auto& e : engineIds)
+		XHost_AxiDmaSetFifoResetOnDmaReset(e[0], /*Enable*/1);
+#endif
 
-	// memory for test
-	int n = 10000000;
-	u32* txBuf = (u32*)malloc(n*sizeof(u32)); assert(txBuf);
-	u32* rxBuf = (u32*)malloc(n*sizeof(u32)); assert(rxBuf);
-	for (int ix = 0; ix < n; ++ix)
+	// memory for test: Tx and Rx buffer
+	u32 nBytesMax = *std::max_element(sweepNBytes, sweepNBytes + N_ELEM(sweepNBytes));
+	u32 n = nBytesMax / sizeof(u32);
+	dmaBufferPool dataPool(nBytesMax, /*nBuffers*/2);
+	u32* txBuf = (u32*)dataPool.alloc(); assert(txBuf);
+	u32* rxBuf = (u32*)dataPool.alloc(); assert(rxBuf);
+	for (u32 ix = 0; ix < n; ++ix)
 		txBuf[ix] = ix;
 
-	for (int testcase = 0; testcase < 11; ++testcase){
-		// overwrite Rx buffer to detect data error
-		memset(rxBuf, /*value*/0, /*nBytes*/n*sizeof(u32));
-
-		int nTest = n;
-		int packetSizeTest = 1 << 13;
-		switch (testcase){
-			case 0: default:
-				packetSizeTest <<= 0;
-				break;
-			case 1:
-				packetSizeTest >>= 1;
-				break;
-			case 2:
-				packetSizeTest >>= 2;
-				break;
-			case 3:
-				packetSizeTest >>= 3;
-				break;
-			case 4:
-				packetSizeTest >>= 4;
-				break;
-			case 5:
-				packetSizeTest >>= 5;
-				break;
-			case 6:
-				packetSizeTest >>= 6;
-				nTest >>= 1;
-				break;
-			case 7:
-				packetSizeTest >>= 7;
-				nTest >>= 2;
-				break;
-			case 8:
-				packetSizeTest >>= 8;
-				nTest >>= 3;
-				break;
-			case 9:
-				packetSizeTest >>= 9;
-				nTest >>= 4;
-				break;
-			case 10:
-				packetSizeTest >>= 10;
-				nTest >>= 5;
-				break;
-		} // switch
-
-		// set up DMA wrapper for testing
-		dmaFeedBasicConfig c(XPAR_AXIDMA_0_DEVICE_ID, txIntrId, rxIntrId);
-		c.maxPacketSize = packetSizeTest;
-		dmaFeedBasic d(c);
-
-		unsigned int nTxBytesTest = nTest*sizeof(u32);
-		unsigned int nRxBytesTest = nTest*sizeof(u32);
-
-		u64 t1, t2;
-		XTime_GetTime(&t1);
-		d.runStart((char*)txBuf, nTxBytesTest, (char*)rxBuf, nRxBytesTest);
-		dmaFeedBase::run_poll_e status;
-		while (true){
-			status = d.run_poll();
-			if (status != dmaFeedBase::DMAFEED_BUSY)
-				break;
-			//usleep(1);
-		} // while busy
-
-		if (status == dmaFeedBase::DMAFEED_IDLE){
-	 		XTime_GetTime(&t2);
-
-			double t_s = (double)(t2-t1)/COUNTS_PER_SECOND;
-			printf("%.3f us for %i bytes using packet size %u\n", 1e6*t_s, nTxBytesTest, packetSizeTest);
-			double throughput_GBps = nTxBytesTest / t_s / 1e9;
-			printf("throughput %.3f gigabytes per second\n", throughput_GBps);
-			for (int ix = 0; ix < nTest; ++ix)
-				if (rxBuf[ix] != txBuf[ix])
-					printf("verify error at position %i: expected %08lx got %08lx\n", ix, txBuf[ix], rxBuf[ix]);
-		} else if (status == dmaFeedBase::DMAFEED_IDLE_ERROR){
-			printf("completed with DMA error\n");
-		}
+	dmaFeedBasicConfig cBase(XPAR_AXIDMA_0_DEVICE_ID, txIntrId, rxIntrId);
+	printCsvHeader();
+	for (u32 maxPacketSize : sweepMaxPacketSize)
+		for (u32 nBytes : sweepNBytes)
+			for (u32 nBytesAllocBd : sweepNBytesAllocBd)
+				for (u32 coalesceN : sweepCoalesceN)
+					for (u32 coalesceDelay : sweepCoalesceDelay)
+						for (bool coalesceAdaptive : sweepCoalesceAdaptive)
+							for (dmaFeedBaseConfig::completion_e completionMode : sweepCompletionMode){
+								benchCase_t c = {maxPacketSize, nBytes, nBytesAllocBd, coalesceN, coalesceDelay, coalesceAdaptive, completionMode};
+								if (skipCase(c))
+									continue;
+								benchResult_t r;
+								runCase(c, cBase, txBuf, rxBuf, r);
+								printCsvLine(c, r);
+							}
+
+	printf("# === job queue ===\n");
+	printf("jobSize,nJobs,mode,runs,dmaErrors,verifyErrors,min_us,median_us,max_us,median_MBps\n");
+	for (u32 jobSize : sweepJobSize){
+		assert(jobSize * nJobsPerRun <= nBytesMax);
+		for (bool queued : {false, true})
+			runJobsCase(jobSize, queued, cBase, txBuf, rxBuf);
 	}
 
-	printf("Done\r\n");
+#ifdef XHOST_MODEL
+	printf("# === service core ===\n");
+	printf("jobSize,nJobs,mode,runs,dmaErrors,verifyErrors,min_us,median_us,max_us,median_MBps\n");
+	for (u32 jobSize : sweepJobSize)
+		for (unsigned int mode = 0; mode < 3; ++mode)
+			runServiceCoreCase(jobSize, mode, cBase, txBuf, rxBuf);
+#endif
+
+	printf("# === replay ===\n");
+	printf("nBytes,maxPacketSize,nRepeats,mode,runs,dmaErrors,verifyErrors,min_us,median_us,usPerTransfer\n");
+	for (u32 nBytes : sweepReplayNBytes)
+		for (bool replay : {false, true})
+			runReplayCase(nBytes, replay, cBase, txBuf, rxBuf);
+
+	printf("# === variable-length Rx ===\n");
+	printf("packetBytes,capacityBytes,nTransactions,mode,runs,dmaErrors,verifyErrors,median_us,usPerTransaction\n");
+	assert(nJobsPerRun * eofPacketSize + eofCapacity <= nBytesMax);
+	for (unsigned int mode = 0; mode < 3; ++mode)
+		runEofCase(mode, cBase, txBuf, rxBuf);
+
+	printf("# === BD fill ===\n");
+	printf("maxPacketSize,nBytes,bdFill,runs,dmaErrors,verifyErrors,median_us,median_MBps,isrNsPerBd,queueNsPerBd\n");
+	for (u32 maxPacketSize : sweepBdFillPacketSize)
+		for (bool fastBdFill : {false, true})
+			runBdFillCase(maxPacketSize, fastBdFill, cBase, txBuf, rxBuf);
+
+	printf("# === interrupt dispatch ===\n");
+	printf("maxPacketSize,nBytes,dispatch,runs,dmaErrors,verifyErrors,median_us,median_MBps,irqPerRun,isrNsPerBd,collectNsPerBd\n");
+	for (u32 maxPacketSize : sweepDispatchPacketSize)
+		for (bool inlineIsr : {false, true})
+			runDispatchCase(maxPacketSize, inlineIsr, cBase, txBuf, rxBuf);
+
+#ifdef XHOST_MODEL
+	printf("# === cyclic capture ===\n");
+	printf("nBuffers,bufferSize,nBytes,mode,runs,dmaErrors,verifyErrors,median_us,median_MBps,rxIrqPerRun,isrUsPerRun\n");
+	for (unsigned int mode = 0; mode < 3; ++mode)
+		runCaptureCase(mode, cBase, txBuf, rxBuf);
+#endif
+
+#ifdef XHOST_MODEL
+	printf("# === error recovery ===\n");
+	printf("nBytes,maxPacketSize,mode,errorAtBd,runs,dmaErrors,verifyErrors,median_us,median_MBps,resumesPerRun,resentKBPerRun\n");
+	for (u32 errorAtBd : sweepErrorAtBd)
+		for (bool resume : {false, true})
+			runRecoveryCase(errorAtBd, resume, cBase, txBuf, rxBuf);
+#endif
+
+	printf("# === pipe ===\n");
+	printf("nBytes,mode,runs,dmaErrors,verifyErrors,median_us,median_MBps,bufferKB\n");
+	for (bool pipe : {false, true})
+		runPipeCase(nBytesMax, pipe, cBase, txBuf, rxBuf);
+
+#ifdef XHOST_MODEL
+	printf("# === single direction ===\n");
+	printf("nBytes,mode,runs,dmaErrors,verifyErrors,median_us,median_MBps,startup_us,txIrqPerRun,rxIrqPerRun\n");
+	for (unsigned int mode = 0; mode < 3; ++mode)
+		runSingleDirCase(mode, cBase, txBuf, rxBuf);
+#endif
+
+	printf("# === multiple engines ===\n");
+	printf("nEngines,nBytesPerEngine,runs,dmaErrors,verifyErrors,min_us,median_us,max_us,aggregate_MBps\n");
+	{
+		dmaBufferPool enginePool(multiEngineNBytes, /*Tx and Rx per engine*/2 * N_ELEM(engineIds));
+		for (unsigned int nEngines = 1; nEngines <= N_ELEM(engineIds); ++nEngines)
+			runMultiEngineCase(nEngines, enginePool);
+	}
+
+	dataPool.free((char*)txBuf);
+	dataPool.free((char*)rxBuf);
+#if DMAFEED_TRACE
+	// most recent events (end of the multi-engine table), see tools/dmaTrace.py
+	dmaTrace::dump();
+#endif
+	printf("# Done\r\n");
+#ifndef XHOST_MODEL
 	while (1){}
+#endif
 
 	return 0;
 }
@@ -0,0 +1,96 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+#include <atomic>
+
+// padding granule against false sharing (same default as dmaBufferPool.h)
+#ifndef DMAFEED_CACHE_LINE
+#	define DMAFEED_CACHE_LINE 64
+#endif
+
+// lock-free FIFO for exactly one producer and one consumer context (e.g. interrupt callback and application code, or two cores)
+// capacity is fixed at construction, no allocation afterwards
+// - write and read position live on separate cache lines, each with the side's last seen copy of the other position
+//   => between cores, the other side's line is fetched only when the queue looks full (producer) / empty (consumer)
+template<typename T> class spscQueue{
+public:
+	spscQueue(unsigned int capacity) : nSlots(capacity + 1), slots(new T[capacity + 1]){}
+	~spscQueue(){delete[] slots;}
+	spscQueue(const spscQueue&) = delete;
+	spscQueue& operator=(const spscQueue&) = delete;
+
+	// producer side. Returns false if full
+	bool push(const T& v){
+		unsigned int w = wrIx.load(std::memory_order_relaxed);
+		unsigned int wNext = next(w);
+		if (wNext == rdIxSeen){
+			rdIxSeen = rdIx.load(std::memory_order_acquire);
+			if (wNext == rdIxSeen)
+				return false;
+		}
+		slots[w] = v;
+		wrIx.store(wNext, std::memory_order_release); // publishes slot
+		return true;
+	}
+
+	// consumer side. Returns false if empty
+	bool pop(T& v){
+		unsigned int r = rdIx.load(std::memory_order_relaxed);
+		if (!available(r))
+			return false;
+		v = slots[r];
+		rdIx.store(next(r), std::memory_order_release); // returns slot to producer
+		return true;
+	}
+
+	// consumer side: copy of the oldest entry without removing it. Returns false if empty
+	bool peek(T& v){
+		unsigned int r = rdIx.load(std::memory_order_relaxed);
+		if (!available(r))
+			return false;
+		v = slots[r];
+		return true;
+	}
+
+	// snapshot, exact only from either side with the other one idle
+	unsigned int size() const{
+		unsigned int w = wrIx.load(std::memory_order_acquire);
+		unsigned int r = rdIx.load(std::memory_order_acquire);
+		return (w >= r) ? w - r : w + nSlots - r;
+	}
+
+	bool empty() const{
+		return size() == 0;
+	}
+
+	// discards all entries. Only while neither side is active
+	void clear(){
+		unsigned int w = wrIx.load(std::memory_order_relaxed);
+		rdIx.store(w, std::memory_order_relaxed);
+		rdIxSeen = w;
+		wrIxSeen = w;
+	}
+
+private:
+	unsigned int next(unsigned int ix) const{
+		return (ix + 1 == nSlots) ? 0 : ix + 1;
+	}
+
+	// consumer side: entry at r, refreshing the seen write position only if the last one says empty
+	bool available(unsigned int r){
+		if (r != wrIxSeen)
+			return true;
+		wrIxSeen = wrIx.load(std::memory_order_acquire);
+		return r != wrIxSeen;
+	}
+
+	// one slot stays empty to tell "full" from "empty"
+	const unsigned int nSlots;
+	T* const slots;
+	// producer line
+	alignas(DMAFEED_CACHE_LINE) std::atomic<unsigned int> wrIx{0};
+	unsigned int rdIxSeen = 0;
+	// consumer line (object size rounds up to the alignment => nothing else on it)
+	alignas(DMAFEED_CACHE_LINE) std::atomic<unsigned int> rdIx{0};
+	unsigned int wrIxSeen = 0;
+};
+#endif
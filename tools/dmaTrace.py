@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+# converts a dmaTrace::dump() (e.g. the tail of the benchmark output, or a UART log) into
+# - a text timeline (default): time since the first event, gap to the previous event of the same engine, BDs in hardware per ring
+# - Chrome trace JSON (--chrome out.json): open in chrome://tracing or ui.perfetto.dev. One process per DMA engine with
+#   Tx / Rx threads (interrupt callbacks as slices, BdRingToHw / -FromHw as instants, BDs in hardware as counters) and a
+#   transaction thread (runStart() .. done())
+# BDs in hardware are inferred from toHw / fromHw counts since the start of the dump (reset: 0) => exact only for rings
+# traced from empty, e.g. from the first runStart() in the dump.
+import argparse
+import json
+import sys
+
+
+def parse(lines):
+	countsPerSecond = None
+	events = []
+	inDump = False
+	for line in lines:
+		line = line.strip()
+		if line.startswith('# dmaTrace countsPerSecond='):
+			countsPerSecond = int(line.split()[2].split('=')[1])
+			events = [] # last dump wins
+			inDump = True
+			continue
+		if not inDump or not line or line.startswith('t,'):
+			continue
+		if line.startswith('#'):
+			inDump = False
+			continue
+		t, devId, direction, event, arg = line.split(',')
+		events.append((int(t, 16), int(devId), direction, event, int(arg, 16)))
+	if countsPerSecond is None:
+		sys.exit('no dmaTrace dump found')
+	return countsPerSecond, events
+
+
+def hwCounts(events):
+	# BDs in hardware per (devId, dir) after each event
+	hw = {}
+	out = []
+	for t, devId, direction, event, arg in events:
+		key = (devId, direction)
+		if event == 'toHw':
+			hw[key] = hw.get(key, 0) + arg
+		elif event == 'fromHw':
+			hw[key] = max(hw.get(key, 0) - arg, 0) # ring not traced from empty
+		elif event == 'reset':
+			hw[(devId, 'tx')] = hw[(devId, 'rx')] = 0
+		out.append(hw.get(key, 0))
+	return out
+
+
+def timeline(countsPerSecond, events, f):
+	if not events:
+		return
+	t0 = events[0][0]
+	tPrev = {}
+	f.write('%12s %10s %5s %3s %-9s %10s %6s\n' % ('t_us', 'gap_us', 'devId', 'dir', 'event', 'arg', 'hwBds'))
+	for (t, devId, direction, event, arg), nHw in zip(events, hwCounts(events)):
+		gap = (t - tPrev[devId]) * 1e6 / countsPerSecond if devId in tPrev else 0.0
+		tPrev[devId] = t
+		argText = '0x%08x' % arg if event in ('irqEntry', 'error') else str(arg)
+		hwText = str(nHw) if event in ('toHw', 'fromHw') else ''
+		f.write('%12.3f %10.3f %5d %3s %-9s %10s %6s\n' % ((t - t0) * 1e6 / countsPerSecond, gap, devId, direction, event, argText, hwText))
+
+
+def chrome(countsPerSecond, events, f):
+	t0 = events[0][0] if events else 0
+	out = []
+	inIrq = set() # (devId, dir) with open interrupt slice
+	inRun = set() # devId with open transaction slice
+	for (t, devId, direction, event, arg), nHw in zip(events, hwCounts(events)):
+		ts = (t - t0) * 1e6 / countsPerSecond
+		tid = 0 if direction == 'tx' else 1
+		key = (devId, direction)
+		if event == 'irqEntry':
+			out.append({'name': 'irq ' + direction, 'ph': 'B', 'ts': ts, 'pid': devId, 'tid': tid, 'args': {'status': '0x%08x' % arg}})
+			inIrq.add(key)
+		elif event == 'irqExit':
+			if key in inIrq: # entry may have been overwritten
+				out.append({'name': 'irq ' + direction, 'ph': 'E', 'ts': ts, 'pid': devId, 'tid': tid, 'args': {'bds': arg}})
+				inIrq.discard(key)
+		elif event in ('toHw', 'fromHw'):
+			out.append({'name': event, 'ph': 'i', 's': 't', 'ts': ts, 'pid': devId, 'tid': tid, 'args': {'bds': arg}})
+			out.append({'name': 'hwBds ' + direction, 'ph': 'C', 'ts': ts, 'pid': devId, 'args': {'bds': nHw}})
+		elif event == 'runStart':
+			if devId in inRun: # previous transaction ended without done() (error)
+				out.append({'name': 'transaction', 'ph': 'E', 'ts': ts, 'pid': devId, 'tid': 2})
+			out.append({'name': 'transaction', 'ph': 'B', 'ts': ts, 'pid': devId, 'tid': 2})
+			inRun.add(devId)
+		elif event == 'done':
+			if devId in inRun:
+				out.append({'name': 'transaction', 'ph': 'E', 'ts': ts, 'pid': devId, 'tid': 2})
+				inRun.discard(devId)
+		else: # error, reset
+			out.append({'name': event, 'ph': 'i', 's': 'p', 'ts': ts, 'pid': devId, 'tid': tid, 'args': {'arg': '0x%08x' % arg}})
+	for devId in sorted(set(e[1] for e in events)):
+		out.append({'name': 'process_name', 'ph': 'M', 'pid': devId, 'args': {'name': 'DMA %d' % devId}})
+		for tid, name in enumerate(('tx', 'rx', 'transaction')):
+			out.append({'name': 'thread_name', 'ph': 'M', 'pid': devId, 'tid': tid, 'args': {'name': name}})
+	json.dump({'traceEvents': out, 'displayTimeUnit': 'ns'}, f)
+
+
+def main():
+	ap = argparse.ArgumentParser(description='dmaTrace dump to timeline / Chrome trace JSON')
+	ap.add_argument('dump', nargs='?', help='file with dmaTrace::dump() output (default: stdin)')
+	ap.add_argument('--chrome', metavar='OUT', help='write Chrome trace JSON to OUT instead of the text timeline')
+	args = ap.parse_args()
+	with (open(args.dump) if args.dump else sys.stdin) as f:
+		countsPerSecond, events = parse(f)
+	if args.chrome:
+		with open(args.chrome, 'w') as f:
+			chrome(countsPerSecond, events, f)
+	else:
+		timeline(countsPerSecond, events, sys.stdout)
+
+
+if __name__ == '__main__':
+	main()